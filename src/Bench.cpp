@@ -0,0 +1,503 @@
+#include "Bench.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "BitWavefront.h"
+#include "ChunkedGrid.h"
+#include "Grid.h"
+#include "HierarchicalPathfinder.h"
+#include "Random.h"
+#include "VoxelGrid.h"
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double millisecondsSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Turn about percent of the cells into obstacles, keeping the two corners the queries run between free
+    void scatterObstacles(Grid& grid, Random& random, int percent) {
+        int width = grid.getWidth();
+        int height = grid.getHeight();
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (random.below(100) < static_cast<uint32_t>(percent) && grid.getCellContent(x, y) == CellContent::Empty) {
+                    grid.setCellContent(x, y, CellContent::Obstacle);
+                }
+            }
+        }
+        grid.setCellContent(0, 0, CellContent::Empty);
+        grid.setCellContent(width - 1, height - 1, CellContent::Empty);
+    }
+
+    // Depth-first maze: passages on even coordinates with walls in between, then one wall in ten knocked
+    // out so there are loops and more than one route. The far passage corner is returned through goalX/goalY.
+    void carveMaze(Grid& grid, Random& random, int& goalX, int& goalY) {
+        int width = grid.getWidth();
+        int height = grid.getHeight();
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                grid.setCellContent(x, y, CellContent::Obstacle);
+            }
+        }
+
+        const int steps[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+        int cellsX = (width + 1) / 2;
+        int cellsY = (height + 1) / 2;
+        std::vector<unsigned char> visited(cellsX * cellsY, 0);
+        std::vector<int> stack(1, 0);
+        visited[0] = 1;
+        grid.setCellContent(0, 0, CellContent::Empty);
+        while (!stack.empty()) {
+            int cellX = stack.back() % cellsX;
+            int cellY = stack.back() / cellsX;
+            int options[4];
+            int count = 0;
+            for (int k = 0; k < 4; ++k) {
+                int nextX = cellX + steps[k][0];
+                int nextY = cellY + steps[k][1];
+                if (nextX >= 0 && nextX < cellsX && nextY >= 0 && nextY < cellsY && !visited[nextY * cellsX + nextX]) {
+                    options[count++] = k;
+                }
+            }
+            if (count == 0) {
+                stack.pop_back();
+                continue;
+            }
+
+            int k = options[random.below(count)];
+            int nextX = cellX + steps[k][0];
+            int nextY = cellY + steps[k][1];
+            visited[nextY * cellsX + nextX] = 1;
+            grid.setCellContent(2 * cellX + steps[k][0], 2 * cellY + steps[k][1], CellContent::Empty);
+            grid.setCellContent(2 * nextX, 2 * nextY, CellContent::Empty);
+            stack.push_back(nextY * cellsX + nextX);
+        }
+
+        for (int y = 0; y < height; ++y) {
+            for (int x = (y + 1) % 2; x < width; x += 2) {
+                if (random.below(10) == 0) {
+                    grid.setCellContent(x, y, CellContent::Empty);
+                }
+            }
+        }
+        goalX = 2 * (cellsX - 1);
+        goalY = 2 * (cellsY - 1);
+    }
+
+    // Textbook queue BFS over Grid::isWalkable, the baseline for the bitboard searches. Stops at the goal
+    // if one is given (goalCell < 0: floods everything). Returns the goal's distance, or the cells reached.
+    int plainBfs(const Grid& grid, int startCell, int goalCell, std::vector<int>& distance, std::vector<int>& queue) {
+        int width = grid.getWidth();
+        distance.assign(width * grid.getHeight(), -1);
+        queue.clear();
+        distance[startCell] = 0;
+        queue.push_back(startCell);
+        for (size_t head = 0; head < queue.size(); ++head) {
+            int cell = queue[head];
+            if (cell == goalCell) {
+                return distance[cell];
+            }
+            int x = cell % width;
+            int y = cell / width;
+            const int neighbors[4][2] = { { x - 1, y }, { x + 1, y }, { x, y - 1 }, { x, y + 1 } };
+            for (const auto& neighbor : neighbors) {
+                int next = neighbor[1] * width + neighbor[0];
+                if (grid.isWalkable(neighbor[0], neighbor[1]) && distance[next] < 0) {
+                    distance[next] = distance[cell] + 1;
+                    queue.push_back(next);
+                }
+            }
+        }
+        return goalCell < 0 ? static_cast<int>(queue.size()) - 1 : -1;
+    }
+
+    // Corner to corner A* on boards with 20% obstacles. Small boards repeat the query to get a measurable time.
+    void benchBoardSizes() {
+        std::cout << "A* corner to corner, 20% obstacles" << std::endl;
+        std::cout << std::setw(10) << "board" << std::setw(10) << "path" << std::setw(12) << "expanded" << std::setw(14) << "ms/query" << std::endl;
+
+        const int sizes[] = { 20, 64, 256, 512, 1024, 2048 };
+        std::vector<int> path;
+        for (int size : sizes) {
+            Grid grid(size, size, CellLayout::Bytes, 1);
+            Random random(size);
+            scatterObstacles(grid, random, 20);
+
+            int repeats = std::max(1, 4000000 / (size * size));
+            grid.findPath(0, 0, size - 1, size - 1, path); // Warm up the search buffers
+            Clock::time_point start = Clock::now();
+            for (int i = 0; i < repeats; ++i) {
+                grid.findPath(0, 0, size - 1, size - 1, path);
+            }
+            double milliseconds = millisecondsSince(start) / repeats;
+
+            std::cout << std::setw(10) << size << std::setw(10) << path.size() << std::setw(12) << grid.getLastExpandedNodes()
+                      << std::setw(14) << std::fixed << std::setprecision(4) << milliseconds << std::endl;
+        }
+        std::cout << std::endl;
+    }
+    // The two cell layouts on the same boards: what the contents and the whole board hold per cell, and what
+    // reading walkability from bytes or from the planes costs an A* query. Counting is the planes' bulk query.
+    void benchCellLayouts() {
+        std::cout << "Cell layouts, 20% obstacles" << std::endl;
+        std::cout << std::setw(8) << "size" << std::setw(8) << "layout" << std::setw(14) << "contents B/c" << std::setw(12) << "board B/c"
+                  << std::setw(12) << "board MB" << std::setw(12) << "A* ms" << std::setw(12) << "count ms" << std::endl;
+
+        const int sizes[] = { 1024, 2048 };
+        std::vector<int> path;
+        for (int size : sizes) {
+            for (int planes = 0; planes < 2; ++planes) {
+                Grid grid(size, size, planes ? CellLayout::BitPlanes : CellLayout::Bytes, 1);
+                Random random(size);
+                scatterObstacles(grid, random, 20);
+
+                grid.findPath(0, 0, size - 1, size - 1, path);
+                const int repeats = 3;
+                Clock::time_point start = Clock::now();
+                for (int i = 0; i < repeats; ++i) {
+                    grid.findPath(0, 0, size - 1, size - 1, path);
+                }
+                double query = millisecondsSince(start) / repeats;
+
+                start = Clock::now();
+                grid.countCells(CellContent::Obstacle);
+                double count = millisecondsSince(start);
+
+                double cells = static_cast<double>(size) * size;
+                std::cout << std::setw(8) << size << std::setw(8) << (planes ? "planes" : "bytes") << std::fixed << std::setprecision(3)
+                          << std::setw(14) << grid.getContentBytes() / cells << std::setw(12) << std::setprecision(1) << grid.getMemoryBytes() / cells
+                          << std::setw(12) << grid.getMemoryBytes() / (1024.0 * 1024.0) << std::setw(12) << query
+                          << std::setw(12) << std::setprecision(2) << count << std::endl;
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    // A* against jump point search on the same queries: path lengths must match, expansions should not.
+    // The last column flips one random cell before each query, as a moving snake does, so it includes
+    // the jump table columns JPS rebuilds after an edit.
+    void benchJumpPoint() {
+        std::cout << "A* and jump point search, corner to corner" << std::endl;
+        std::cout << std::setw(8) << "board" << std::setw(8) << "size" << std::setw(12) << "algorithm" << std::setw(10) << "path"
+                  << std::setw(12) << "expanded" << std::setw(14) << "ms/query" << std::setw(14) << "ms/edited" << std::endl;
+
+        const int sizes[] = { 256, 1024 };
+        std::vector<int> path;
+        for (int maze = 0; maze < 2; ++maze) {
+            for (int size : sizes) {
+                Grid grid(size, size, CellLayout::Bytes, 1);
+                Random random(size);
+                int goalX = size - 1, goalY = size - 1;
+                if (maze) {
+                    carveMaze(grid, random, goalX, goalY);
+                }
+                else {
+                    grid.setCellContent(goalX, goalY, CellContent::Empty); // In case the pill landed there
+                }
+
+                for (int jump = 0; jump < 2; ++jump) {
+                    PathAlgorithm algorithm = jump ? PathAlgorithm::JumpPoint : PathAlgorithm::AStar;
+                    int repeats = std::max(1, 1000000 / (size * size));
+                    grid.findPath(0, 0, goalX, goalY, path, algorithm);
+                    Clock::time_point start = Clock::now();
+                    for (int i = 0; i < repeats; ++i) {
+                        grid.findPath(0, 0, goalX, goalY, path, algorithm);
+                    }
+                    double milliseconds = millisecondsSince(start) / repeats;
+                    size_t pathLength = path.size();
+                    int expanded = grid.getLastExpandedNodes();
+
+                    // Each cell is flipped twice, so the board ends as it started
+                    std::vector<int> edits;
+                    for (int i = 0; i < repeats; ++i) {
+                        int cell = static_cast<int>(random.below(size * size));
+                        if (cell != 0 && cell != goalY * size + goalX && grid.getCellContent(cell % size, cell / size) != CellContent::Pill) {
+                            edits.push_back(cell);
+                        }
+                    }
+                    start = Clock::now();
+                    for (int pass = 0; pass < 2; ++pass) {
+                        for (int cell : edits) {
+                            int x = cell % size, y = cell / size;
+                            grid.setCellContent(x, y, grid.isWalkable(x, y) ? CellContent::Obstacle : CellContent::Empty);
+                            grid.findPath(0, 0, goalX, goalY, path, algorithm);
+                        }
+                    }
+                    double edited = millisecondsSince(start) / std::max<size_t>(2 * edits.size(), 1);
+
+                    std::cout << std::setw(8) << (maze ? "maze" : "open") << std::setw(8) << size << std::setw(12) << (jump ? "JPS" : "A*")
+                              << std::setw(10) << pathLength << std::setw(12) << expanded
+                              << std::setw(14) << std::fixed << std::setprecision(4) << milliseconds << std::setw(14) << edited << std::endl;
+                }
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    // Pill placement on crowded boards: the free-cell index against drawing random cells until one is empty.
+    // Both place the pill and eat it straight away, so the occupancy stays put.
+    void benchPillPlacement() {
+        std::cout << "Pill placement, 1024x1024" << std::endl;
+        std::cout << std::setw(10) << "occupied" << std::setw(12) << "free cells" << std::setw(16) << "index ns"
+                  << std::setw(16) << "rejection ns" << std::setw(16) << "draws/pill" << std::endl;
+
+        const int size = 1024;
+        const int occupancies[] = { 50, 90, 99 };
+        const int placements = 100000;
+        for (int occupancy : occupancies) {
+            Grid grid(size, size, CellLayout::Bytes, 1);
+            Random random(occupancy);
+
+            // Block a shuffled prefix of the cells, so exactly that share of the board is taken
+            std::vector<int> order(size * size);
+            for (int i = 0; i < size * size; ++i) {
+                order[i] = i;
+            }
+            for (int i = size * size - 1; i > 0; --i) {
+                std::swap(order[i], order[random.below(i + 1)]);
+            }
+            for (int i = 0; i < size * size; ++i) {
+                CellContent content = i < size * size / 100 * occupancy ? CellContent::Obstacle : CellContent::Empty;
+                grid.setCellContent(order[i] % size, order[i] / size, content);
+            }
+
+            Clock::time_point start = Clock::now();
+            for (int i = 0; i < placements; ++i) {
+                grid.placePill();
+                int cell = grid.getPillCell();
+                grid.setCellContent(cell % size, cell / size, CellContent::Empty);
+            }
+            double indexed = millisecondsSince(start) * 1e6 / placements;
+
+            long long draws = 0;
+            start = Clock::now();
+            for (int i = 0; i < placements; ++i) {
+                int x, y;
+                do {
+                    x = static_cast<int>(random.below(size));
+                    y = static_cast<int>(random.below(size));
+                    draws++;
+                } while (grid.getCellContent(x, y) != CellContent::Empty);
+                grid.setCellContent(x, y, CellContent::Pill);
+                grid.setCellContent(x, y, CellContent::Empty);
+            }
+            double rejection = millisecondsSince(start) * 1e6 / placements;
+
+            std::cout << std::setw(9) << occupancy << "%" << std::setw(12) << grid.getFreeCellCount()
+                      << std::setw(16) << std::fixed << std::setprecision(1) << indexed << std::setw(16) << rejection
+                      << std::setw(16) << static_cast<double>(draws) / placements << std::endl;
+        }
+        std::cout << std::endl;
+    }
+
+    // BitWavefront against the plain BFS on 2048x2048: a corner to corner distance, which grows waves, and
+    // a flood from the centre, which counts reachable cells with whole-run row fills
+    void benchWavefront() {
+        std::cout << "Bit wavefront and plain BFS, 2048x2048" << std::endl;
+        std::cout << std::setw(8) << "board" << std::setw(12) << "query" << std::setw(10) << "result"
+                  << std::setw(12) << "BFS ms" << std::setw(12) << "bits ms" << std::endl;
+
+        const int size = 2048;
+        std::vector<int> distance, queue;
+        for (int maze = 0; maze < 2; ++maze) {
+            Grid grid(size, size, CellLayout::Bytes, 1);
+            Random random(size);
+            int goalX = size - 1, goalY = size - 1;
+            if (maze) {
+                carveMaze(grid, random, goalX, goalY);
+            }
+            else {
+                scatterObstacles(grid, random, 20);
+            }
+            BitWavefront wavefront(grid);
+            wavefront.countReachable(0, 0); // Builds the bitboard
+
+            for (int flood = 0; flood < 2; ++flood) {
+                int startX = flood ? size / 2 : 0;
+                int startY = flood ? size / 2 : 0;
+                Clock::time_point start = Clock::now();
+                int result = plainBfs(grid, startY * size + startX, flood ? -1 : goalY * size + goalX, distance, queue);
+                double bfs = millisecondsSince(start);
+                start = Clock::now();
+                int bits = flood ? wavefront.countReachable(startX, startY) : wavefront.getDistance(startX, startY, goalX, goalY);
+                double wave = millisecondsSince(start);
+                if (bits != result) {
+                    std::cout << "Bit wavefront disagrees with BFS: " << bits << " vs " << result << std::endl;
+                }
+
+                std::cout << std::setw(8) << (maze ? "maze" : "open") << std::setw(12) << (flood ? "flood" : "distance")
+                          << std::setw(10) << bits << std::fixed << std::setprecision(1)
+                          << std::setw(12) << bfs << std::setw(12) << wave << std::endl;
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    // HPA* across a 2048x2048 board with 20% obstacles. "near" is the first query of a fresh planner over a
+    // short distance, which only cuts the clusters around it; "build" the first corner to corner query, which
+    // cuts every cluster it reaches; "query" the same path again. Then a walker follows findNextLeg from corner
+    // to corner, asking again after every step while an obstacle somewhere on the board changes every 16 steps.
+    void benchHierarchical() {
+        std::cout << "HPA* corner to corner, 2048x2048, 20% obstacles" << std::endl;
+        std::cout << std::setw(8) << "cluster" << std::setw(10) << "near ms" << std::setw(10) << "build ms" << std::setw(10) << "query ms" << std::setw(10) << "path"
+                  << std::setw(8) << "steps" << std::setw(12) << "us/step" << std::setw(14) << "worst us" << std::endl;
+
+        const int size = 2048;
+        const int clusterSizes[] = { 8, 16, 32 };
+        std::vector<int> path;
+        for (int clusterSize : clusterSizes) {
+            Grid grid(size, size, CellLayout::Bytes, 1);
+            Random random(size);
+            scatterObstacles(grid, random, 20);
+            Clock::time_point start = Clock::now();
+            {
+                HierarchicalPathfinder fresh(grid, clusterSize);
+                fresh.findPath(size / 2, size / 2, size / 2 + 64, size / 2 + 64, path);
+            }
+            double near = millisecondsSince(start);
+
+            HierarchicalPathfinder pathfinder(grid, clusterSize);
+            start = Clock::now();
+            pathfinder.findPath(0, 0, size - 1, size - 1, path);
+            double build = millisecondsSince(start);
+            start = Clock::now();
+            pathfinder.findPath(0, 0, size - 1, size - 1, path);
+            double query = millisecondsSince(start);
+            size_t pathLength = path.size();
+
+            int x = 0, y = 0;
+            int steps = 0;
+            double worst = 0.0;
+            start = Clock::now();
+            while ((x != size - 1 || y != size - 1) && steps < 4 * size * 2) {
+                if (steps % 16 == 0) {
+                    int cell = static_cast<int>(random.below(size * size));
+                    if (cell != y * size + x && cell != size * size - 1) {
+                        grid.setCellContent(cell % size, cell / size,
+                                            grid.isWalkable(cell % size, cell / size) ? CellContent::Obstacle : CellContent::Empty);
+                    }
+                }
+                Clock::time_point stepStart = Clock::now();
+                if (!pathfinder.findNextLeg(x, y, size - 1, size - 1, path) || path.empty()) {
+                    break;
+                }
+                worst = std::max(worst, millisecondsSince(stepStart) * 1000.0);
+                x = path.front() % size;
+                y = path.front() / size;
+                steps++;
+            }
+            double perStep = millisecondsSince(start) * 1000.0 / std::max(steps, 1);
+
+            std::cout << std::setw(8) << clusterSize << std::fixed << std::setprecision(1) << std::setw(10) << near << std::setw(10) << build
+                      << std::setw(10) << query << std::setw(10) << pathLength << std::setw(8) << steps
+                      << std::setw(12) << std::setprecision(2) << perStep << std::setw(14) << std::setprecision(0) << worst << std::endl;
+        }
+        std::cout << std::endl;
+    }
+
+    // 6-connected A* in a voxel arena with 20% obstacles: random cell to random cell, and corner to corner
+    void benchVoxels() {
+        std::cout << "Voxel A*, 20% obstacles" << std::endl;
+        std::cout << std::setw(8) << "arena" << std::setw(12) << "query" << std::setw(10) << "path"
+                  << std::setw(12) << "expanded" << std::setw(14) << "ms/query" << std::endl;
+
+        const int sizes[] = { 64, 256 };
+        const int queries = 200;
+        std::vector<Voxel> path;
+        for (int size : sizes) {
+            VoxelGrid arena(size, size, size);
+            Random random(size);
+            for (int z = 0; z < size; ++z) {
+                for (int y = 0; y < size; ++y) {
+                    for (int x = 0; x < size; ++x) {
+                        if (random.below(100) < 20) {
+                            arena.setCellContent(x, y, z, CellContent::Obstacle);
+                        }
+                    }
+                }
+            }
+            arena.setCellContent(0, 0, 0, CellContent::Empty);
+            arena.setCellContent(size - 1, size - 1, size - 1, CellContent::Empty);
+
+            long long pathCells = 0, expanded = 0;
+            Clock::time_point start = Clock::now();
+            for (int i = 0; i < queries; ++i) {
+                Voxel from = { static_cast<int>(random.below(size)), static_cast<int>(random.below(size)), static_cast<int>(random.below(size)) };
+                Voxel to = { static_cast<int>(random.below(size)), static_cast<int>(random.below(size)), static_cast<int>(random.below(size)) };
+                arena.findPath(from, to, path);
+                pathCells += path.size();
+                expanded += arena.getLastExpandedNodes();
+            }
+            double randomQuery = millisecondsSince(start) / queries;
+            std::cout << std::setw(8) << size << std::setw(12) << "random" << std::setw(10) << pathCells / queries
+                      << std::setw(12) << expanded / queries << std::setw(14) << std::fixed << std::setprecision(4) << randomQuery << std::endl;
+
+            start = Clock::now();
+            arena.findPath(Voxel{ 0, 0, 0 }, Voxel{ size - 1, size - 1, size - 1 }, path);
+            double corner = millisecondsSince(start);
+            std::cout << std::setw(8) << size << std::setw(12) << "corner" << std::setw(10) << path.size()
+                      << std::setw(12) << arena.getLastExpandedNodes() << std::setw(14) << corner << std::endl;
+        }
+        std::cout << std::endl;
+    }
+
+    // Sparse content on a 100k x 100k plane: clusters of cells around random centres, as a long game leaves
+    // behind. Memory is what the chunks hold, against one byte per cell for the dense board. The window
+    // scan is the draw-around-the-head query, 41x41 cells on a cluster, against visiting every chunk.
+    void benchChunkedWorld() {
+        std::cout << "Chunked world, 100000x100000 plane (dense board: 10000000 KB)" << std::endl;
+        std::cout << std::setw(10) << "cells" << std::setw(10) << "chunks" << std::setw(12) << "KB"
+                  << std::setw(12) << "window us" << std::setw(10) << "in view" << std::setw(10) << "all ms" << std::endl;
+
+        const int side = 100000;
+        const int clusterCells[] = { 10000, 100000, 1000000 };
+        for (int cells : clusterCells) {
+            ChunkedGrid world;
+            Random random(cells);
+            std::vector<int> centres; // x, y pairs
+            for (int i = 0; i < cells; ++i) {
+                if (i % 1000 == 0) {
+                    centres.push_back(static_cast<int>(random.below(side)));
+                    centres.push_back(static_cast<int>(random.below(side)));
+                }
+                int centreX = centres[centres.size() - 2], centreY = centres.back();
+                world.setCellContent(centreX + static_cast<int>(random.below(64)), centreY + static_cast<int>(random.below(64)), CellContent::Obstacle);
+            }
+
+            const int windows = 1000;
+            long long inView = 0;
+            Clock::time_point start = Clock::now();
+            for (int i = 0; i < windows; ++i) {
+                size_t centre = 2 * random.below(static_cast<uint32_t>(centres.size() / 2));
+                int x = centres[centre] + 32, y = centres[centre + 1] + 32;
+                world.forEachCellIn(CellContent::Obstacle, x - 20, y - 20, x + 20, y + 20, [&](int, int) { inView++; });
+            }
+            double window = millisecondsSince(start) * 1000.0 / windows;
+
+            long long visited = 0;
+            start = Clock::now();
+            world.forEachCell(CellContent::Obstacle, [&](int, int) { visited++; });
+            double all = millisecondsSince(start);
+
+            std::cout << std::setw(10) << visited << std::setw(10) << world.getChunkCount() << std::setw(12) << world.getMemoryBytes() / 1024
+                      << std::fixed << std::setprecision(2) << std::setw(12) << window << std::setw(10) << std::setprecision(1)
+                      << static_cast<double>(inView) / windows << std::setw(10) << all << std::endl;
+        }
+        std::cout << std::endl;
+    }
+}
+
+void runBenchmarks() {
+    benchBoardSizes();
+    benchCellLayouts();
+    benchJumpPoint();
+    benchPillPlacement();
+    benchWavefront();
+    benchHierarchical();
+    benchVoxels();
+    benchChunkedWorld();
+}
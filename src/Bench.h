@@ -0,0 +1,8 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// Timings for the pathfinding and board code, printed as tables (Snake3DOpenGL --bench).
+// Boards are generated from fixed seeds, so runs on the same machine can be compared.
+void runBenchmarks();
+
+#endif // BENCH_H
@@ -0,0 +1,25 @@
+#ifndef BIT_OPS_H
+#define BIT_OPS_H
+
+#include <cstdint>
+#include <bitset>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Index of the lowest set bit; word must not be zero
+inline int lowestBit(uint64_t word) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+inline int popCount(uint64_t word) {
+    return static_cast<int>(std::bitset<64>(word).count());
+}
+
+#endif // BIT_OPS_H
@@ -0,0 +1,440 @@
+#include "BitWavefront.h"
+#include <algorithm>
+#include "BitOps.h"
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#define BIT_WAVEFRONT_AVX2
+#define AVX2_FUNCTION // MSVC compiles AVX2 intrinsics without /arch:AVX2
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BIT_WAVEFRONT_AVX2
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+
+namespace {
+    // Occluded fills: spread the set bits of g through runs of open bits, towards the high (or low) end
+    // of the word, in six doubling steps
+    uint64_t spreadHigh(uint64_t g, uint64_t open) {
+        g |= open & (g << 1);
+        open &= open << 1;
+        g |= open & (g << 2);
+        open &= open << 2;
+        g |= open & (g << 4);
+        open &= open << 4;
+        g |= open & (g << 8);
+        open &= open << 8;
+        g |= open & (g << 16);
+        open &= open << 16;
+        return g | (open & (g << 32));
+    }
+
+    uint64_t spreadLow(uint64_t g, uint64_t open) {
+        g |= open & (g >> 1);
+        open &= open >> 1;
+        g |= open & (g >> 2);
+        open &= open >> 2;
+        g |= open & (g >> 4);
+        open &= open >> 4;
+        g |= open & (g >> 8);
+        open &= open >> 8;
+        g |= open & (g >> 16);
+        open &= open >> 16;
+        return g | (open & (g >> 32));
+    }
+
+#if defined(BIT_WAVEFRONT_AVX2)
+    // The AVX2 loop is always compiled in, and only taken on CPUs (and OSes) that support it
+    bool detectAvx2() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        return osSavesYmm && (info[1] & (1 << 5));
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    const bool hasAvx2 = detectAvx2();
+
+    // Four words of one row's wave at a time, from word w while a whole group fits before to; returns where it stopped
+    AVX2_FUNCTION int growWordsAvx2(const uint64_t* current, const uint64_t* above, const uint64_t* below,
+                                    const uint64_t* open, uint64_t* seen, uint64_t* grown, int w, int to) {
+        for (; w + 4 <= to + 1; w += 4) {
+            __m256i middle = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current + w));
+            __m256i lower = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current + w - 1));
+            __m256i upper = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current + w + 1));
+            __m256i fromLeft = _mm256_or_si256(_mm256_slli_epi64(middle, 1), _mm256_srli_epi64(lower, 63));
+            __m256i fromRight = _mm256_or_si256(_mm256_srli_epi64(middle, 1), _mm256_slli_epi64(upper, 63));
+            __m256i vertical = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(above + w)),
+                                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(below + w)));
+            __m256i reached = _mm256_and_si256(_mm256_or_si256(_mm256_or_si256(fromLeft, fromRight), vertical),
+                                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(open + w)));
+            __m256i seenBefore = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(seen + w));
+            __m256i fresh = _mm256_andnot_si256(seenBefore, reached);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(grown + w), fresh);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(seen + w), _mm256_or_si256(seenBefore, fresh));
+        }
+        return w;
+    }
+#endif
+}
+
+BitWavefront::BitWavefront(Grid& grid) : grid(grid) {
+    grid.addListener(this);
+}
+
+BitWavefront::~BitWavefront() {
+    grid.removeListener(this);
+}
+
+void BitWavefront::onWalkabilityChanged(int x, int y, bool isWalkable) {
+    if (width == grid.getWidth() && height == grid.getHeight()) {
+        if (isWalkable) setBit(walkable, x, y);
+        else clearBit(walkable, x, y);
+    }
+}
+
+void BitWavefront::onGridReset() {
+    // The next query rebuilds the bitboard
+    width = 0;
+    height = 0;
+}
+
+// Build the bitboard from the grid the first time (or after a resize); listeners keep it current after that
+void BitWavefront::sync() {
+    if (width == grid.getWidth() && height == grid.getHeight()) {
+        return;
+    }
+    width = grid.getWidth();
+    height = grid.getHeight();
+    stride = (width + 63) / 64 + 2;
+
+    size_t words = static_cast<size_t>(stride) * (height + 2);
+    walkable.assign(words, 0);
+    visited.assign(words, 0);
+    frontier.assign(words, 0);
+    next.assign(words, 0);
+    layer.assign(static_cast<size_t>(width) * height, 0);
+    frontierFirst.assign(height + 2, stride);
+    frontierLast.assign(height + 2, -1);
+    nextFirst.assign(height + 2, stride);
+    nextLast.assign(height + 2, -1);
+    pendingFirst.assign(height + 2, stride);
+    pendingLast.assign(height + 2, -1);
+    pendingRows.reserve(height);
+    frontierRows.clear();
+    frontierRows.reserve(height);
+    nextRows.clear();
+    nextRows.reserve(height);
+    rowWave.assign(height + 2, 0);
+    waveCount = 0;
+    visitedFirst.assign(height + 2, stride);
+    visitedLast.assign(height + 2, -1);
+    visitedRows.clear();
+    visitedRows.reserve(height);
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (grid.isWalkable(x, y)) {
+                setBit(walkable, x, y);
+            }
+        }
+    }
+}
+
+bool BitWavefront::growRow(int y) {
+    // New cells can only appear within a word of the frontier in this row or the rows next to it
+    int words = stride - 2;
+    int from = std::max(std::min(std::min(frontierFirst[y], frontierFirst[y + 1]), frontierFirst[y + 2]) - 1, 0);
+    int to = std::min(std::max(std::max(frontierLast[y], frontierLast[y + 1]), frontierLast[y + 2]) + 1, words - 1);
+    if (from > to) {
+        return false;
+    }
+
+    const uint64_t* current = row(frontier, y);
+    const uint64_t* above = row(frontier, y - 1);
+    const uint64_t* below = row(frontier, y + 1);
+    const uint64_t* open = row(walkable, y);
+    uint64_t* seen = row(visited, y);
+    uint64_t* grown = row(next, y);
+
+    int w = from;
+#if defined(BIT_WAVEFRONT_AVX2)
+    if (hasAvx2) {
+        w = growWordsAvx2(current, above, below, open, seen, grown, w, to);
+    }
+#endif
+
+    // Scalar path (and the tail the vector loop didn't cover). The padding words supply zero carries at the edges.
+    for (; w <= to; ++w) {
+        uint64_t fromLeft = (current[w] << 1) | (current[w - 1] >> 63);
+        uint64_t fromRight = (current[w] >> 1) | (current[w + 1] << 63);
+        uint64_t fresh = (fromLeft | fromRight | above[w] | below[w]) & open[w] & ~seen[w];
+        grown[w] = fresh;
+        seen[w] |= fresh;
+    }
+
+    // The span of the new frontier; usually only a word or two wide, so these scans stop quickly
+    int first = from;
+    while (first <= to && grown[first] == 0) {
+        first++;
+    }
+    if (first > to) {
+        return false;
+    }
+    int last = to;
+    while (grown[last] == 0) {
+        last--;
+    }
+    nextFirst[y + 1] = first;
+    nextLast[y + 1] = last;
+    markVisited(y, first, last);
+    return true;
+}
+
+// Zero the frontier words still set and forget their spans
+void BitWavefront::clearFrontier() {
+    for (int y : frontierRows) {
+        std::fill(row(frontier, y) + frontierFirst[y + 1], row(frontier, y) + frontierLast[y + 1] + 1, 0);
+        frontierFirst[y + 1] = stride;
+        frontierLast[y + 1] = -1;
+    }
+    frontierRows.clear();
+}
+
+void BitWavefront::markVisited(int y, int first, int last) {
+    if (visitedFirst[y + 1] > visitedLast[y + 1]) {
+        visitedRows.push_back(y);
+    }
+    visitedFirst[y + 1] = std::min(visitedFirst[y + 1], first);
+    visitedLast[y + 1] = std::max(visitedLast[y + 1], last);
+}
+
+void BitWavefront::clearVisited() {
+    for (int y : visitedRows) {
+        std::fill(row(visited, y) + visitedFirst[y + 1], row(visited, y) + visitedLast[y + 1] + 1, 0);
+        visitedFirst[y + 1] = stride;
+        visitedLast[y + 1] = -1;
+    }
+    visitedRows.clear();
+}
+
+int BitWavefront::search(int startX, int startY, int goalX, int goalY, bool recordLayers) {
+    // Only the last wave of the previous search is left in frontier; next is always left empty
+    sync();
+    clearVisited();
+    clearFrontier();
+
+    // The start may be blocked (the snake's head is); it still seeds the first wave
+    setBit(frontier, startX, startY);
+    frontierFirst[startY + 1] = startX >> 6;
+    frontierLast[startY + 1] = startX >> 6;
+    frontierRows.push_back(startY);
+    setBit(visited, startX, startY);
+    markVisited(startY, startX >> 6, startX >> 6);
+    if (recordLayers) {
+        layer[startY * width + startX] = 0;
+    }
+    if (startX == goalX && startY == goalY) {
+        return 0;
+    }
+
+    // Only the rows holding frontier and the ones next to them can change during a wave. In a maze the
+    // frontier is a few cells scattered over most of the board, so the rows between them are skipped.
+    for (int wave = 1; ; ++wave) {
+        waveCount++;
+        for (int frontierRow : frontierRows) {
+            for (int y = std::max(frontierRow - 1, 0); y <= std::min(frontierRow + 1, height - 1); ++y) {
+                if (rowWave[y + 1] != waveCount) {
+                    rowWave[y + 1] = waveCount;
+                    if (growRow(y)) {
+                        nextRows.push_back(y);
+                    }
+                }
+            }
+        }
+        if (nextRows.empty()) {
+            return goalX < 0 ? wave - 1 : -1;
+        }
+
+        // Clear the old frontier before it becomes the next scratch buffer, so no stale words survive outside the spans
+        clearFrontier();
+        frontier.swap(next);
+        frontierFirst.swap(nextFirst);
+        frontierLast.swap(nextLast);
+        frontierRows.swap(nextRows);
+
+        if (recordLayers) {
+            for (int y : frontierRows) {
+                const uint64_t* bits = row(frontier, y);
+                for (int w = frontierFirst[y + 1]; w <= frontierLast[y + 1]; ++w) {
+                    for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+                        layer[y * width + w * 64 + lowestBit(word)] = wave;
+                    }
+                }
+            }
+        }
+        if (goalX >= 0 && testBit(visited, goalX, goalY)) {
+            return wave;
+        }
+    }
+}
+
+void BitWavefront::queueRow(int y, int first, int last) {
+    if (y < 0 || y >= height) {
+        return;
+    }
+    if (pendingFirst[y + 1] > pendingLast[y + 1]) {
+        pendingRows.push_back(y);
+    }
+    pendingFirst[y + 1] = std::min(pendingFirst[y + 1], first);
+    pendingLast[y + 1] = std::max(pendingLast[y + 1], last);
+}
+
+// Every row of visited is kept closed under left and right moves. When a row's neighbor gains cells in some
+// words, the row takes the cells under them as seeds and spreads them along its runs, carrying across words
+// only as far as a run goes. The words it changed then queue the rows above and below.
+bool BitWavefront::flood(int startX, int startY, int goalX, int goalY) {
+    sync();
+    clearVisited();
+    for (int y : pendingRows) {
+        pendingFirst[y + 1] = stride; // Left queued when the previous flood stopped at its goal
+        pendingLast[y + 1] = -1;
+    }
+    pendingRows.clear();
+
+    // The start may be blocked (the snake's head is); it still seeds its own row and the ones next to it
+    setBit(visited, startX, startY);
+    markVisited(startY, startX >> 6, startX >> 6);
+    for (int y = startY - 1; y <= startY + 1; ++y) {
+        queueRow(y, startX >> 6, startX >> 6);
+    }
+
+    int words = stride - 2;
+    while (!pendingRows.empty()) {
+        int y = pendingRows.back();
+        pendingRows.pop_back();
+        int first = pendingFirst[y + 1];
+        int last = pendingLast[y + 1];
+        pendingFirst[y + 1] = stride;
+        pendingLast[y + 1] = -1;
+
+        const uint64_t* open = row(walkable, y);
+        const uint64_t* above = row(visited, y - 1);
+        const uint64_t* below = row(visited, y + 1);
+        uint64_t* seen = row(visited, y);
+        int changedFirst = words, changedLast = -1;
+
+        // Seed and spread towards higher words, then back towards lower ones
+        uint64_t carry = 0;
+        for (int w = first; w < words; ++w) {
+            uint64_t seeds = carry & open[w];
+            if (w <= last) {
+                seeds |= (above[w] | below[w]) & open[w];
+            }
+            else if ((seeds & ~seen[w]) == 0) {
+                break; // The run carries on into cells that are already visited
+            }
+            uint64_t filled = spreadHigh(seen[w] | seeds, open[w]);
+            carry = filled >> 63;
+            if (filled != seen[w]) {
+                seen[w] = filled;
+                changedFirst = std::min(changedFirst, w);
+                changedLast = std::max(changedLast, w);
+            }
+        }
+        carry = 0;
+        for (int w = std::min(last, words - 1); w >= 0; --w) {
+            uint64_t seeds = (carry << 63) & open[w];
+            if (w < first && (seeds & ~seen[w]) == 0) {
+                break;
+            }
+            uint64_t filled = spreadLow(seen[w] | seeds, open[w]);
+            carry = filled & 1;
+            if (filled != seen[w]) {
+                seen[w] = filled;
+                changedFirst = std::min(changedFirst, w);
+                changedLast = std::max(changedLast, w);
+            }
+        }
+
+        if (changedLast >= 0) {
+            markVisited(y, changedFirst, changedLast);
+            if (y == goalY && testBit(visited, goalX, goalY)) {
+                return true;
+            }
+            queueRow(y - 1, changedFirst, changedLast);
+            queueRow(y + 1, changedFirst, changedLast);
+        }
+    }
+    return goalX >= 0 && testBit(visited, goalX, goalY);
+}
+
+bool BitWavefront::isReachable(int startX, int startY, int goalX, int goalY) {
+    if (!grid.isInside(startX, startY) || !grid.isWalkable(goalX, goalY)) {
+        return startX == goalX && startY == goalY;
+    }
+    return (startX == goalX && startY == goalY) || flood(startX, startY, goalX, goalY);
+}
+
+int BitWavefront::getDistance(int startX, int startY, int goalX, int goalY) {
+    if (!grid.isInside(startX, startY) || !grid.isWalkable(goalX, goalY)) {
+        return (startX == goalX && startY == goalY) ? 0 : -1;
+    }
+    return search(startX, startY, goalX, goalY, false);
+}
+
+int BitWavefront::countReachable(int x, int y) {
+    if (!grid.isInside(x, y)) {
+        return 0;
+    }
+    flood(x, y, -1, -1);
+
+    int count = 0;
+    for (int y : visitedRows) {
+        for (int w = visitedFirst[y + 1]; w <= visitedLast[y + 1]; ++w) {
+            count += popCount(row(visited, y)[w]);
+        }
+    }
+    return count - 1;
+}
+
+std::vector<int> BitWavefront::findPath(int startX, int startY, int goalX, int goalY) {
+    std::vector<int> path;
+    findPath(startX, startY, goalX, goalY, path);
+    return path;
+}
+
+bool BitWavefront::findPath(int startX, int startY, int goalX, int goalY, std::vector<int>& path) {
+    path.clear();
+    if (!grid.isInside(startX, startY) || !grid.isWalkable(goalX, goalY)) {
+        return false;
+    }
+    int distance = search(startX, startY, goalX, goalY, true);
+    if (distance < 0) {
+        return false;
+    }
+
+    // Walk back from the goal, each time to a neighbor reached one wave earlier
+    const int offsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+    path.resize(distance);
+    int x = goalX, y = goalY;
+    for (int wave = distance; wave > 0; --wave) {
+        path[wave - 1] = y * width + x;
+        for (auto& offset : offsets) {
+            int neighborX = x + offset[0];
+            int neighborY = y + offset[1];
+            if (neighborX >= 0 && neighborX < width && neighborY >= 0 && neighborY < height &&
+                testBit(visited, neighborX, neighborY) && layer[neighborY * width + neighborX] == wave - 1) {
+                x = neighborX;
+                y = neighborY;
+                break;
+            }
+        }
+    }
+    return true;
+}
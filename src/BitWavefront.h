@@ -0,0 +1,70 @@
+#ifndef BIT_WAVEFRONT_H
+#define BIT_WAVEFRONT_H
+
+#include <vector>
+#include <cstdint>
+#include "Grid.h"
+
+// Breadth-first search over a bitboard copy of the grid's walkability: one bit per cell, rows of 64-bit
+// words. A whole wave of the BFS is grown with shifts, ORs and ANDs, so each instruction advances 64 cells
+// (256 where the CPU has AVX2, checked at run time). Each row also keeps the span of words its frontier occupies,
+// and a wave only scans the spans around the rows that hold frontier, so the cost follows the frontier rather
+// than the board. Queries clear only the words the previous one touched.
+// Reachability and space counting don't need the waves: they flood whole runs of a row at once instead.
+// Used for reachability, distances, flood-fill space counting and paths on big boards.
+class BitWavefront : public GridListener {
+public:
+    explicit BitWavefront(Grid& grid);
+    ~BitWavefront();
+    BitWavefront(const BitWavefront&) = delete;
+    BitWavefront& operator=(const BitWavefront&) = delete;
+
+    bool isReachable(int startX, int startY, int goalX, int goalY);
+    int getDistance(int startX, int startY, int goalX, int goalY); // Steps from start to goal, -1 if unreachable
+    int countReachable(int x, int y); // Walkable cells reachable from (x, y), not counting (x, y) itself
+    std::vector<int> findPath(int startX, int startY, int goalX, int goalY); // Cells, start excluded, goal included
+    bool findPath(int startX, int startY, int goalX, int goalY, std::vector<int>& path); // Same, into a reused path
+
+    void onWalkabilityChanged(int x, int y, bool walkable) override;
+    void onGridReset() override;
+
+private:
+    Grid& grid;
+    int width = 0, height = 0;
+    int stride = 0; // Words per row, including one zero padding word on each side
+
+    // Row-major, with a zero padding row above and below, so neighbor reads never need bounds checks
+    std::vector<uint64_t> walkable, visited, frontier, next;
+    std::vector<int> layer; // Wave that first reached each cell, only meaningful where visited is set
+    // Per padded row: first and last word holding frontier (or next) bits; first > last when there are none
+    std::vector<int> frontierFirst, frontierLast, nextFirst, nextLast;
+    std::vector<int> frontierRows, nextRows; // Rows with a non-empty span, in no particular order
+    std::vector<int> rowWave; // Per padded row: last wave that grew it, so a row shared by two frontier rows grows once
+    int waveCount = 0; // Waves grown since the bitboard was built, stamped into rowWave
+    // Words of visited set by the last query, per padded row, so the next one clears only those
+    std::vector<int> visitedFirst, visitedLast;
+    std::vector<int> visitedRows;
+    // Flood fill: rows waiting to be filled again, and the words of each whose neighbors changed
+    std::vector<int> pendingRows;
+    std::vector<int> pendingFirst, pendingLast;
+
+    void sync();
+    uint64_t* row(std::vector<uint64_t>& bits, int y) { return &bits[(y + 1) * stride + 1]; }
+    bool testBit(std::vector<uint64_t>& bits, int x, int y) { return (row(bits, y)[x >> 6] >> (x & 63)) & 1; }
+    void setBit(std::vector<uint64_t>& bits, int x, int y) { row(bits, y)[x >> 6] |= uint64_t(1) << (x & 63); }
+    void clearBit(std::vector<uint64_t>& bits, int x, int y) { row(bits, y)[x >> 6] &= ~(uint64_t(1) << (x & 63)); }
+
+    // Grow waves from the start until the goal is reached (goalX < 0: until nothing new is found).
+    // Returns the number of waves, or -1 if the goal was given and never reached.
+    int search(int startX, int startY, int goalX, int goalY, bool recordLayers);
+    bool growRow(int y); // One wave for one row; returns true if it reached a new cell
+    void clearFrontier();
+    void markVisited(int y, int first, int last);
+    void clearVisited();
+    // Mark visited every cell connected to the start, without keeping waves; stops early once the goal is visited
+    // (goalX < 0: never). Returns whether the goal was visited.
+    bool flood(int startX, int startY, int goalX, int goalY);
+    void queueRow(int y, int first, int last);
+};
+
+#endif // BIT_WAVEFRONT_H
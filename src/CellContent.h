@@ -1,7 +1,11 @@
-enum class CellContent {
+#ifndef CELL_CONTENT_H
+#define CELL_CONTENT_H
+
+enum class CellContent : unsigned char {
     Empty,
     Snake,
     Obstacle,
-    Pill,
-    Path
+    Pill
 };
+
+#endif // CELL_CONTENT_H
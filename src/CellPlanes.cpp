@@ -0,0 +1,88 @@
+#include "CellPlanes.h"
+#include <algorithm>
+#include <cstring>
+
+void CellPlanes::resize(int width, int height) {
+    this->width = width;
+    this->height = height;
+    size_t words = (static_cast<size_t>(width) * height + 63) / 64;
+    for (auto& plane : planes) {
+        plane.assign(words, 0);
+    }
+}
+
+CellContent CellPlanes::get(int x, int y) const {
+    int cell = y * width + x;
+    for (int i = 0; i < planeCount; ++i) {
+        if ((planes[i][cell >> 6] >> (cell & 63)) & 1) {
+            return static_cast<CellContent>(i + 1);
+        }
+    }
+    return CellContent::Empty;
+}
+
+void CellPlanes::set(int x, int y, CellContent content) {
+    int cell = y * width + x;
+    uint64_t mask = uint64_t(1) << (cell & 63);
+    for (auto& plane : planes) {
+        plane[cell >> 6] &= ~mask;
+    }
+    if (content != CellContent::Empty) {
+        planes[planeOf(content)][cell >> 6] |= mask;
+    }
+}
+
+void CellPlanes::assign(CellContent content, const uint64_t* bits) {
+    for (auto& plane : planes) {
+        std::fill(plane.begin(), plane.end(), 0);
+    }
+    if (content == CellContent::Empty || planes[0].empty()) {
+        return;
+    }
+
+    // Same layout, so the whole plane is one copy; only the bits past the last cell need clearing
+    std::vector<uint64_t>& plane = planes[planeOf(content)];
+    std::memcpy(plane.data(), bits, plane.size() * sizeof(uint64_t));
+    size_t cells = static_cast<size_t>(width) * height;
+    if (cells & 63) {
+        plane.back() &= (uint64_t(1) << (cells & 63)) - 1;
+    }
+}
+
+int CellPlanes::count(CellContent content) const {
+    if (content == CellContent::Empty) {
+        int filled = 0;
+        for (int i = 0; i < planeCount; ++i) {
+            filled += count(static_cast<CellContent>(i + 1));
+        }
+        return width * height - filled;
+    }
+
+    int total = 0;
+    for (uint64_t word : planes[planeOf(content)]) {
+        total += popCount(word);
+    }
+    return total;
+}
+
+bool CellPlanes::findFirst(CellContent content, int& x, int& y) const {
+    for (size_t w = 0; w < planes[0].size(); ++w) {
+        uint64_t word = planeWord(content, w);
+        if (word != 0) {
+            int cell = static_cast<int>(w * 64) + lowestBit(word);
+            x = cell % width;
+            y = cell / width;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CellPlanes::getBlocked(std::vector<uint64_t>& blocked) const {
+    const std::vector<uint64_t>& obstacles = planes[planeOf(CellContent::Obstacle)];
+    const std::vector<uint64_t>& snake = planes[planeOf(CellContent::Snake)];
+    blocked.resize(obstacles.size());
+    for (size_t w = 0; w < obstacles.size(); ++w) {
+        blocked[w] = obstacles[w] | snake[w];
+    }
+}
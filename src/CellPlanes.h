@@ -0,0 +1,65 @@
+#ifndef CELL_PLANES_H
+#define CELL_PLANES_H
+
+#include <vector>
+#include <cstdint>
+#include "CellContent.h"
+#include "BitOps.h"
+
+// Cell contents stored as one bitset per content type instead of one enum per cell. Cell (x, y) is bit
+// y * width + x of every plane; Empty has no plane of its own (a cell is empty when no plane has it),
+// so queries about Empty work on the complement of the other three.
+// Questions about a whole content type become word-wide operations: counting is a popcount, finding
+// the pill is a scan for the first non-zero word, and "blocked" is the OR of two planes.
+class CellPlanes {
+public:
+    void resize(int width, int height); // Every cell becomes Empty
+
+    CellContent get(int x, int y) const;
+    void set(int x, int y, CellContent content);
+    // Cells whose bit is set in bits (laid out like a plane) hold content, every other cell becomes Empty
+    void assign(CellContent content, const uint64_t* bits);
+
+    int count(CellContent content) const;
+    bool findFirst(CellContent content, int& x, int& y) const; // First cell in row-major order, false if none
+    void getBlocked(std::vector<uint64_t>& blocked) const; // Obstacle | Snake, one bit per cell
+    // Snake or Obstacle at cell (y * width + x): what the snake can't enter, from two bits of the same word
+    bool isBlocked(int cell) const {
+        return (((planes[planeOf(CellContent::Snake)][cell >> 6] | planes[planeOf(CellContent::Obstacle)][cell >> 6]) >> (cell & 63)) & 1) != 0;
+    }
+    size_t getMemoryBytes() const { return planeCount * planes[0].capacity() * sizeof(uint64_t); }
+
+    // Calls visit(x, y) for every cell holding content, in row-major order
+    template <typename Visit>
+    void forEach(CellContent content, Visit visit) const {
+        for (size_t w = 0; w < planes[0].size(); ++w) {
+            for (uint64_t word = planeWord(content, w); word != 0; word &= word - 1) {
+                int cell = static_cast<int>(w * 64) + lowestBit(word);
+                visit(cell % width, cell / width);
+            }
+        }
+    }
+
+private:
+    static const int planeCount = 3; // Snake, Obstacle, Pill
+    std::vector<uint64_t> planes[planeCount];
+    int width = 0, height = 0;
+
+    // Empty maps to no plane: use planeWord for anything that may be asked about Empty
+    static int planeOf(CellContent content) { return static_cast<int>(content) - 1; }
+
+    // Word w of the plane for content. Empty's word is built from the other planes, without the bits past the last cell.
+    uint64_t planeWord(CellContent content, size_t w) const {
+        if (content != CellContent::Empty) {
+            return planes[planeOf(content)][w];
+        }
+        uint64_t word = ~(planes[0][w] | planes[1][w] | planes[2][w]);
+        size_t cells = static_cast<size_t>(width) * height;
+        if ((w + 1) * 64 > cells) {
+            word &= (uint64_t(1) << (cells & 63)) - 1;
+        }
+        return word;
+    }
+};
+
+#endif // CELL_PLANES_H
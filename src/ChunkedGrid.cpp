@@ -0,0 +1,44 @@
+#include "ChunkedGrid.h"
+
+CellContent ChunkedGrid::getCellContent(int x, int y) const {
+    int cx = chunkOf(x), cy = chunkOf(y);
+    auto found = chunks.find(keyOf(cx, cy));
+    if (found == chunks.end()) {
+        return CellContent::Empty;
+    }
+    return found->second->cells[(y - cy * chunkSize) * chunkSize + (x - cx * chunkSize)];
+}
+
+void ChunkedGrid::setCellContent(int x, int y, CellContent content) {
+    int cx = chunkOf(x), cy = chunkOf(y);
+    uint64_t key = keyOf(cx, cy);
+    auto found = chunks.find(key);
+    if (found == chunks.end()) {
+        if (content == CellContent::Empty) {
+            return; // Already implicitly empty
+        }
+        found = chunks.emplace(key, std::unique_ptr<Chunk>(new Chunk())).first;
+    }
+
+    Chunk& chunk = *found->second;
+    CellContent& cell = chunk.cells[(y - cy * chunkSize) * chunkSize + (x - cx * chunkSize)];
+    chunk.counts[static_cast<int>(cell)]--;
+    chunk.counts[static_cast<int>(content)]++;
+    cell = content;
+
+    if (chunk.counts[static_cast<int>(CellContent::Empty)] == chunkSize * chunkSize) {
+        chunks.erase(found);
+    }
+}
+
+void ChunkedGrid::clear() {
+    chunks.clear();
+}
+
+int ChunkedGrid::countCells(CellContent content) const {
+    int total = 0;
+    for (const auto& entry : chunks) {
+        total += entry.second->counts[static_cast<int>(content)];
+    }
+    return total;
+}
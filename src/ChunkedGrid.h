@@ -0,0 +1,83 @@
+#ifndef CHUNKED_GRID_H
+#define CHUNKED_GRID_H
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include "CellContent.h"
+
+// Sparse cell storage for huge or unbounded worlds. The plane is cut into square chunks that are only
+// allocated when something other than Empty is written into them, and freed again once they are empty,
+// so memory follows the content rather than the area. Coordinates may be any int, negative included.
+// Same getCellContent/setCellContent API as Grid; bulk queries skip the chunks that can't match.
+class ChunkedGrid {
+public:
+    static const int chunkSize = 64;
+
+    CellContent getCellContent(int x, int y) const; // Empty wherever nothing was written
+    void setCellContent(int x, int y, CellContent content);
+    void clear();
+
+    int countCells(CellContent content) const; // Not Empty: that's every cell outside the chunks
+    int getChunkCount() const { return static_cast<int>(chunks.size()); }
+
+    // Calls visit(x, y) for every cell holding content (not Empty). Chunks are visited in no particular
+    // order; chunks without that content are skipped without looking at their cells.
+    template <typename Visit>
+    void forEachCell(CellContent content, Visit visit) const {
+        for (const auto& entry : chunks) {
+            const Chunk& chunk = *entry.second;
+            if (chunk.counts[static_cast<int>(content)] == 0) continue;
+
+            int originX = chunkX(entry.first) * chunkSize;
+            int originY = chunkY(entry.first) * chunkSize;
+            for (int i = 0; i < chunkSize * chunkSize; ++i) {
+                if (chunk.cells[i] == content) {
+                    visit(originX + i % chunkSize, originY + i / chunkSize);
+                }
+            }
+        }
+    }
+
+    // Same, limited to the cells with minX <= x <= maxX and minY <= y <= maxY: only the chunks overlapping
+    // that window are looked up, so the cost follows the window rather than the whole world.
+    template <typename Visit>
+    void forEachCellIn(CellContent content, int minX, int minY, int maxX, int maxY, Visit visit) const {
+        for (int cy = chunkOf(minY); cy <= chunkOf(maxY); ++cy) {
+            for (int cx = chunkOf(minX); cx <= chunkOf(maxX); ++cx) {
+                auto found = chunks.find(keyOf(cx, cy));
+                if (found == chunks.end() || found->second->counts[static_cast<int>(content)] == 0) continue;
+
+                const Chunk& chunk = *found->second;
+                int originX = cx * chunkSize, originY = cy * chunkSize;
+                int fromX = minX > originX ? minX - originX : 0, toX = maxX < originX + chunkSize - 1 ? maxX - originX : chunkSize - 1;
+                int fromY = minY > originY ? minY - originY : 0, toY = maxY < originY + chunkSize - 1 ? maxY - originY : chunkSize - 1;
+                for (int y = fromY; y <= toY; ++y) {
+                    for (int x = fromX; x <= toX; ++x) {
+                        if (chunk.cells[y * chunkSize + x] == content) {
+                            visit(originX + x, originY + y);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    size_t getMemoryBytes() const { return chunks.size() * sizeof(Chunk); } // Cell storage held by the chunks
+
+private:
+    struct Chunk {
+        CellContent cells[chunkSize * chunkSize] = {};
+        int counts[4] = { chunkSize * chunkSize, 0, 0, 0 }; // Cells of each content type
+    };
+
+    std::unordered_map<uint64_t, std::unique_ptr<Chunk>> chunks;
+
+    // Floor division, so -1 lands in chunk -1 rather than chunk 0
+    static int chunkOf(int coordinate) { return coordinate >= 0 ? coordinate / chunkSize : -((-coordinate - 1) / chunkSize) - 1; }
+    static uint64_t keyOf(int chunkX, int chunkY) { return (uint64_t(uint32_t(chunkX)) << 32) | uint32_t(chunkY); }
+    static int chunkX(uint64_t key) { return static_cast<int>(uint32_t(key >> 32)); }
+    static int chunkY(uint64_t key) { return static_cast<int>(uint32_t(key)); }
+};
+
+#endif // CHUNKED_GRID_H
@@ -0,0 +1,48 @@
+#ifndef EPOCH_STAMPS_H
+#define EPOCH_STAMPS_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// One stamp per slot of some scratch array, so the whole array can be invalidated in O(1) between searches.
+// advance() starts a new epoch; a slot's scratch only counts while its stamp equals the current epoch.
+// Stamps are 16 bits: the full clear when the counter wraps comes once every 65535 epochs, which costs far
+// less than two more bytes per slot do in cache.
+class EpochStamps {
+public:
+    // Every slot starts out stale
+    void resize(size_t count) {
+        stamps.assign(count, 0);
+        epoch = 1;
+    }
+
+    size_t size() const { return stamps.size(); }
+    size_t getMemoryBytes() const { return stamps.capacity() * sizeof(uint16_t); }
+
+    void advance() {
+        epoch++;
+        if (epoch == 0) {
+            // The counter wrapped around: old stamps could look current again, so clear them once
+            std::fill(stamps.begin(), stamps.end(), 0);
+            epoch = 1;
+        }
+    }
+
+    bool isCurrent(size_t slot) const { return stamps[slot] == epoch; }
+
+    // Stamp the slot; true if it was stale, meaning its scratch must be reset before use
+    bool touch(size_t slot) {
+        if (stamps[slot] == epoch) {
+            return false;
+        }
+        stamps[slot] = epoch;
+        return true;
+    }
+
+private:
+    std::vector<uint16_t> stamps;
+    uint16_t epoch = 1;
+};
+
+#endif // EPOCH_STAMPS_H
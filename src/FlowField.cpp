@@ -0,0 +1,223 @@
+#include "FlowField.h"
+#include <algorithm>
+#include <functional>
+
+FlowField::FlowField(Grid& grid) : grid(grid) {
+    grid.addListener(this);
+}
+
+FlowField::~FlowField() {
+    grid.removeListener(this);
+}
+
+void FlowField::onWalkabilityChanged(int x, int y, bool) {
+    if (goal < 0 || stale) {
+        return;
+    }
+    if (static_cast<int>(changedCells.size()) >= width * height) {
+        stale = true;
+        changedCells.clear();
+        return;
+    }
+    changedCells.push_back(y * width + x);
+}
+
+void FlowField::onGridReset() {
+    // No field until the next setGoal rebuilds it
+    goal = -1;
+    changedCells.clear();
+    stale = false;
+}
+
+void FlowField::setGoal(int x, int y) {
+    int cell = y * grid.getWidth() + x;
+    if (cell != goal || width != grid.getWidth() || height != grid.getHeight()) {
+        goal = cell;
+        rebuild();
+    }
+}
+
+int FlowField::getDistance(int x, int y) {
+    if (goal < 0 || x < 0 || x >= width || y < 0 || y >= height) {
+        return -1;
+    }
+    applyChanges();
+    int value = distance[y * width + x];
+    return value == infinity() ? -1 : value;
+}
+
+bool FlowField::getNextStep(int x, int y, int& nextX, int& nextY) {
+    if (goal < 0 || x < 0 || x >= width || y < 0 || y >= height) {
+        return false;
+    }
+    applyChanges();
+
+    int neighbors[4];
+    int count = neighborsOf(y * width + x, neighbors);
+    int best = infinity();
+    for (int i = 0; i < count; ++i) {
+        if (isWalkableCell(neighbors[i]) && distance[neighbors[i]] < best) {
+            best = distance[neighbors[i]];
+            nextX = neighbors[i] % width;
+            nextY = neighbors[i] / width;
+        }
+    }
+    return best != infinity();
+}
+
+int FlowField::neighborsOf(int cell, int* neighbors) const {
+    int x = cell % width;
+    int y = cell / width;
+    int count = 0;
+    if (x > 0) neighbors[count++] = cell - 1;
+    if (x < width - 1) neighbors[count++] = cell + 1;
+    if (y > 0) neighbors[count++] = cell - width;
+    if (y < height - 1) neighbors[count++] = cell + width;
+    return count;
+}
+
+void FlowField::rebuild() {
+    width = grid.getWidth();
+    height = grid.getHeight();
+    distance.assign(width * height, infinity());
+    if (invalid.size() != distance.size()) {
+        invalid.resize(distance.size());
+    }
+    changedCells.clear();
+    stale = false;
+
+    // The goal is the source even if something is sitting on it
+    distance[goal] = 0;
+    queue.clear();
+    queue.push_back(goal);
+    propagate(0);
+    lastUpdatedCells = static_cast<int>(queue.size());
+}
+
+void FlowField::propagate(size_t head) {
+    int neighbors[4];
+    for (; head < queue.size(); ++head) {
+        int cell = queue[head];
+        int count = neighborsOf(cell, neighbors);
+        for (int i = 0; i < count; ++i) {
+            int neighbor = neighbors[i];
+            if (isWalkableCell(neighbor) && distance[neighbor] > distance[cell] + 1) {
+                distance[neighbor] = distance[cell] + 1;
+                queue.push_back(neighbor);
+            }
+        }
+    }
+}
+
+void FlowField::applyChanges() {
+    if (stale) {
+        rebuild();
+        return;
+    }
+    if (changedCells.empty()) {
+        return;
+    }
+    lastUpdatedCells = 0;
+
+    // A cell may have flipped more than once; only its current state matters
+    for (int cell : changedCells) {
+        if (cell == goal) continue;
+        if (isWalkableCell(cell)) cellOpened(cell);
+        else cellBlocked(cell);
+    }
+    changedCells.clear();
+}
+
+// A cell opening up can only shorten distances: give it one, then let the decrease spread
+void FlowField::cellOpened(int cell) {
+    int neighbors[4];
+    int count = neighborsOf(cell, neighbors);
+    for (int i = 0; i < count; ++i) {
+        // A blocked neighbor may still hold a distance from before it was blocked, until its own change is applied
+        if (carriesDistance(neighbors[i]) && distance[neighbors[i]] != infinity()) {
+            distance[cell] = std::min(distance[cell], distance[neighbors[i]] + 1);
+        }
+    }
+    if (distance[cell] == infinity()) {
+        return;
+    }
+
+    queue.clear();
+    queue.push_back(cell);
+    propagate(0);
+    lastUpdatedCells += static_cast<int>(queue.size());
+}
+
+// A cell getting blocked can only lengthen distances. First find the cells that relied on it: in BFS order,
+// a cell loses its distance when none of its neighbors outside the lost region is exactly one step closer.
+// Those cells are then re-seeded from the intact cells around them and settled in distance order.
+void FlowField::cellBlocked(int cell) {
+    if (distance[cell] == infinity()) {
+        return;
+    }
+
+    invalid.advance();
+
+    int neighbors[4], supports[4];
+    invalidCells.clear();
+    invalidCells.push_back(cell);
+    invalid.touch(cell);
+    for (size_t head = 0; head < invalidCells.size(); ++head) {
+        int lost = invalidCells[head];
+        int count = neighborsOf(lost, neighbors);
+        for (int i = 0; i < count; ++i) {
+            int child = neighbors[i];
+            if (child == goal || invalid.isCurrent(child) || distance[child] != distance[lost] + 1) continue;
+
+            bool supported = false;
+            int supportCount = neighborsOf(child, supports);
+            for (int j = 0; j < supportCount && !supported; ++j) {
+                int support = supports[j];
+                supported = !invalid.isCurrent(support) && isWalkableCell(support) && distance[support] == distance[child] - 1;
+            }
+            if (!supported) {
+                invalid.touch(child);
+                invalidCells.push_back(child);
+            }
+        }
+    }
+
+    for (int lost : invalidCells) {
+        distance[lost] = infinity();
+    }
+
+    // Re-seed the lost cells from their intact neighbors, then settle them cheapest first
+    typedef std::pair<int, int> Entry; // (distance, cell)
+    std::greater<Entry> later;
+    pending.clear();
+    for (int lost : invalidCells) {
+        if (!isWalkableCell(lost)) continue;
+        int count = neighborsOf(lost, neighbors);
+        for (int i = 0; i < count; ++i) {
+            if (carriesDistance(neighbors[i]) && distance[neighbors[i]] != infinity() && distance[neighbors[i]] + 1 < distance[lost]) {
+                distance[lost] = distance[neighbors[i]] + 1;
+            }
+        }
+        if (distance[lost] != infinity()) {
+            pending.push_back(Entry(distance[lost], lost));
+            std::push_heap(pending.begin(), pending.end(), later);
+        }
+    }
+    while (!pending.empty()) {
+        std::pop_heap(pending.begin(), pending.end(), later);
+        Entry entry = pending.back();
+        pending.pop_back();
+        if (entry.first != distance[entry.second]) continue; // Superseded by a shorter distance
+
+        int count = neighborsOf(entry.second, neighbors);
+        for (int i = 0; i < count; ++i) {
+            int neighbor = neighbors[i];
+            if (isWalkableCell(neighbor) && distance[neighbor] > entry.first + 1) {
+                distance[neighbor] = entry.first + 1;
+                pending.push_back(Entry(distance[neighbor], neighbor));
+                std::push_heap(pending.begin(), pending.end(), later);
+            }
+        }
+    }
+    lastUpdatedCells += static_cast<int>(invalidCells.size());
+}
@@ -0,0 +1,55 @@
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include <vector>
+#include <utility>
+#include "Grid.h"
+#include "EpochStamps.h"
+
+// Distance-to-goal for every cell of the grid, from one reverse BFS out of the goal (the pill).
+// Whoever stands anywhere on the board just steps to the neighbor with the smallest distance.
+// The field is rebuilt when the goal moves; a cell changing walkability is patched in place,
+// touching only the cells whose distance actually changes.
+class FlowField : public GridListener {
+public:
+    explicit FlowField(Grid& grid);
+    ~FlowField();
+    FlowField(const FlowField&) = delete;
+    FlowField& operator=(const FlowField&) = delete;
+
+    void setGoal(int x, int y); // Rebuilds the field if the goal moved
+    int getDistance(int x, int y); // Steps to the goal, -1 if it can't be reached
+    bool getNextStep(int x, int y, int& nextX, int& nextY); // Neighbor that gets closest to the goal
+    int getLastUpdatedCells() const { return lastUpdatedCells; } // Cells rewritten by the last rebuild or patch
+
+    void onWalkabilityChanged(int x, int y, bool) override;
+    void onGridReset() override;
+
+private:
+    Grid& grid;
+    int width = 0, height = 0;
+    int goal = -1;
+    std::vector<int> distance;
+    // Applied lazily, on the next read. At most one entry per cell, like Grid's journal: past that,
+    // patching costs more than a new BFS, so the field is marked stale and rebuilt instead.
+    std::vector<int> changedCells;
+    bool stale = false;
+    int lastUpdatedCells = 0;
+
+    // Scratch for patching after a cell gets blocked
+    EpochStamps invalid; // Cells that lost their distance in the current patch
+    std::vector<int> queue, invalidCells;
+    std::vector<std::pair<int, int>> pending; // Min-heap of (distance, cell), kept for its capacity
+
+    void rebuild();
+    void applyChanges();
+    void cellOpened(int cell);
+    void cellBlocked(int cell);
+    void propagate(size_t head); // BFS relaxation of the queued cells from index head on
+    bool isWalkableCell(int cell) const { return grid.isWalkable(cell % width, cell / width); }
+    bool carriesDistance(int cell) const { return cell == goal || isWalkableCell(cell); } // The goal counts even when occupied
+    int neighborsOf(int cell, int* neighbors) const;
+    static int infinity() { return std::numeric_limits<int>::max(); }
+};
+
+#endif // FLOW_FIELD_H
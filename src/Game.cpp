@@ -1,9 +1,13 @@
 #include "Game.h"
+#include "LevelFile.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <gtc/matrix_transform.hpp>
 #include <gtc/type_ptr.hpp>
 
@@ -16,11 +20,48 @@ int windowHeight = 600;
 Game* Game::gameInstance = nullptr;
 
 // Game constructor
-Game::Game()
-    : window(nullptr), VAO(0), VBO(0), shaderProgram(0),
-    grid(20, 20), snake(grid, Position(0.5f, 0.5f)) { // Initializes the game with a window, a snake at origin, and a 20x20 grid
+Game::Game(bool headless, uint64_t seed, int voxelSize, bool openWorld)
+    : headless(headless), seed(seed), window(nullptr), VAO(0), VBO(0), shaderProgram(0),
+    grid(20, 20, CellLayout::Bytes, seed), snake(grid, Position(0.5f, 0.5f)) { // Initializes the game with a window, a snake at origin, and a 20x20 grid
 
     gameInstance = this; // Sets the static instance pointer to this instance
+    snake.setQuiet(headless); // Per-pill messages would cost more than the ticks being measured
+    // The grid starts with one pill; top the board up to pillCount
+    while (grid.getPillCount() < pillCount && grid.placePill()) {}
+
+    if (voxelSize > 0) {
+        // Scatter obstacles through the arena, leaving the snake's starting corner free
+        voxelGrid.reset(new VoxelGrid(voxelSize, voxelSize, voxelSize));
+        Random random(seed, RandomStream::VoxelObstacles);
+        for (int z = 0; z < voxelGrid->getSizeZ(); ++z) {
+            for (int y = 0; y < voxelGrid->getSizeY(); ++y) {
+                for (int x = 0; x < voxelGrid->getSizeX(); ++x) {
+                    if ((x | y | z) != 0 && random.below(100) < static_cast<uint32_t>(voxelObstaclePercent)) {
+                        voxelGrid->setCellContent(x, y, z, CellContent::Obstacle);
+                        voxelObstacles.push_back({ x, y, z });
+                    }
+                }
+            }
+        }
+        voxelSnake.reset(new VoxelSnake(*voxelGrid, Voxel{ 0, 0, 0 }, seed));
+        voxelSnake->setQuiet(headless);
+    }
+    else if (openWorld) {
+        world.reset(new ChunkedGrid());
+        worldSnake.reset(new WorldSnake(*world, WorldCell{ 0, 0 }, seed));
+        worldSnake->setQuiet(headless);
+    }
+
+    if (headless) {
+        return;
+    }
+
+    // The game's own board is reported here rather than by Grid, so benchmarks and tools that build grids stay quiet
+    std::cout << "Grid initialized with size " << grid.getWidth() << "x" << grid.getHeight() << std::endl;
+
+    // Fill the draw lists once; from here on they follow the grid's change journal
+    grid.setJournaling(true);
+    rebuildDrawLists();
     init(); // Initialize GLFW and GLEW, create window
     shaderProgram = loadShader("shaders/VertexShader.glsl", "shaders/FragmentShader.glsl"); // Load and compile shaders
     setupGrid(); // Setup grid geometry
@@ -29,7 +70,51 @@ Game::Game()
 
 // Game destructor for cleanup
 Game::~Game() {
-    cleanup(); // Cleanup allocated resources
+    if (!headless) {
+        cleanup(); // Cleanup allocated resources
+    }
+}
+
+bool Game::loadLevel(const std::string& path) {
+    if (voxelSnake || worldSnake) {
+        std::cerr << "Levels are for the board, not the voxel or open world modes" << std::endl;
+        return false;
+    }
+    LevelFile level;
+    if (!level.open(path)) {
+        std::cerr << "Could not load level " << path << std::endl;
+        return false;
+    }
+
+    if (level.getWidth() != grid.getWidth() || level.getHeight() != grid.getHeight()) {
+        grid = Grid(level.getWidth(), level.getHeight(), grid.getLayout(), seed);
+        if (!headless) {
+            std::cout << "Grid initialized with size " << grid.getWidth() << "x" << grid.getHeight() << std::endl;
+        }
+    }
+    level.applyTo(grid);
+    snake.reset(level.getSnakeX(), level.getSnakeY()); // The load took the old body off the board
+    while (grid.getPillCount() < pillCount && grid.placePill()) {}
+
+    if (!headless) {
+        grid.setJournaling(true);
+        rebuildDrawLists();
+    }
+    return true;
+}
+
+void Game::setCellLayout(CellLayout layout) {
+    if (layout == grid.getLayout()) {
+        return;
+    }
+    grid = Grid(grid.getWidth(), grid.getHeight(), layout, seed);
+    snake.reset(snake.getHeadX(), snake.getHeadY());
+    while (grid.getPillCount() < pillCount && grid.placePill()) {}
+
+    if (!headless) {
+        grid.setJournaling(true);
+        rebuildDrawLists();
+    }
 }
 
 // Initializes GLFW, creates a window, and initializes GLEW
@@ -177,25 +262,66 @@ void Game::setupCube() {
 // Main game loop
 void Game::run() {
 
-    float lastFrameTime = glfwGetTime();
+    double lastFrameTime = glfwGetTime();
+    double accumulator = 0.0; // Time not yet simulated
 
     while (!glfwWindowShouldClose(window)) {
 
         // Calculate delta time
-        float currentFrameTime = glfwGetTime();
-        float deltaTime = currentFrameTime - lastFrameTime;
+        double currentFrameTime = glfwGetTime();
+        double deltaTime = std::min(currentFrameTime - lastFrameTime, maxFrameTime);
         lastFrameTime = currentFrameTime;
 
-        snake.calculateAndFollowPath();
-        //snake.updateGrid();
-        update();
-        render();
+        // Run as many fixed ticks as the frame covered: none on a fast frame, several on a slow one
+        double tickInterval = 1.0 / tickRate;
+        accumulator += deltaTime;
+        while (accumulator >= tickInterval) {
+            tick();
+            accumulator -= tickInterval;
+        }
+
+        render(static_cast<float>(accumulator / tickInterval));
+        grid.clearChanges(); // Every consumer of the change journal has caught up for this frame
 
         glfwSwapBuffers(window);
         glfwPollEvents(); // Poll for and process events
     }
 }
 
+// Run the simulation as fast as the CPU allows, without touching GLFW or GL
+void Game::runHeadless(long long ticks) {
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < ticks; ++i) {
+        tick();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t length = voxelSnake ? voxelSnake->getLength() : worldSnake ? worldSnake->getLength() : snake.getLength();
+    std::cout << "Headless: seed " << seed << ", " << ticks << " ticks in " << seconds << " s, "
+              << static_cast<long long>(seconds > 0 ? ticks / seconds : 0.0) << " ticks/s, snake length " << length << std::endl;
+    if (!voxelSnake && !worldSnake) {
+        std::cout << "Board: " << grid.getWidth() << "x" << grid.getHeight() << (grid.getLayout() == CellLayout::BitPlanes ? " bit planes" : " bytes")
+                  << ", contents " << grid.getContentBytes() / 1024 << " KB, " << grid.getMemoryBytes() / 1024 << " KB in all" << std::endl;
+    }
+    if (worldSnake) {
+        const WorldCell& head = worldSnake->getBody().front();
+        std::cout << "World: head at (" << head.x << ", " << head.y << "), " << world->getChunkCount() << " chunks, "
+                  << world->getMemoryBytes() / 1024 << " KB of cells" << (worldSnake->isGameOver() ? ", boxed in" : "") << std::endl;
+    }
+}
+
+void Game::tick() {
+    if (voxelSnake || worldSnake) {
+        if (++voxelTicks % ticksPerVoxelMove == 0) {
+            if (voxelSnake) voxelSnake->step();
+            else worldSnake->step();
+        }
+        return;
+    }
+    snake.calculateAndFollowPath();
+    update();
+}
+
 // Update game logic
 void Game::update() {
     
@@ -203,13 +329,22 @@ void Game::update() {
 }
 
 // Render the game
-void Game::render() {
+void Game::render(float alpha) {
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     // Set up the view and projection matrices
     glUseProgram(shaderProgram);
 
+    if (voxelSnake) {
+        renderVoxels();
+        return;
+    }
+    if (worldSnake) {
+        renderWorld();
+        return;
+    }
+
     viewMatrix = glm::lookAt(glm::vec3(0.0f, 15.0f, 15.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     projectionMatrix = glm::perspective(glm::radians(60.0f), 800.0f / 600.0f, 0.1f, 100.0f);
 
@@ -230,7 +365,8 @@ void Game::render() {
 
     // Render the snake
     glUniform3f(glGetUniformLocation(shaderProgram, "color"), 0.0f, 1.0f, 0.0f); // Set color to green for snake
-    for (auto& pos : snake.getBody()) {
+    for (size_t i = 0; i < snake.getLength(); ++i) {
+        Position pos = snake.getSegment(i, alpha);
         glm::mat4 model = glm::translate(glm::mat4(1.0f), pos.toVec3());
         glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
         glBindVertexArray(VAO);
@@ -245,68 +381,152 @@ void Game::render() {
     float offsetY = 0.5f; // place the cube on top of the grid
     float offsetZ = (gridSize * 2.0f) / grid.getHeight() / 2.0f; // Half of cell depth
 
-    for (int x = 0; x < grid.getWidth(); ++x) {
-        for (int y = 0; y < grid.getHeight(); ++y) {
-            if (grid.getCellContent(x, y) == CellContent::Obstacle) {
-
-                glUniform3f(glGetUniformLocation(shaderProgram, "color"), 1.0f, 0.0f, 0.0f); // Set color to red for obstacles
-                // Calculate world position with center offset
-                glm::vec3 worldPos = glm::vec3(
-                    (x - grid.getWidth() / 2.0f) * cellSize + offsetX,
-                    offsetY,
-                    (y - grid.getHeight() / 2.0f) * cellSize + offsetZ
-                );
-
-                glm::mat4 model = glm::translate(glm::mat4(1.0f), worldPos);
-                glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-                glBindVertexArray(VAO);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
-            if (grid.getCellContent(x, y) == CellContent::Pill) {
-                glUniform3f(glGetUniformLocation(shaderProgram, "color"), 0.0f, 0.0f, 1.0f); // Set color to blue for pill
-
-                // Calculate world position with center offset
-                glm::vec3 worldPos = glm::vec3(
-                    (x - grid.getWidth() / 2.0f) * cellSize + offsetX,
-                    offsetY,
-                    (y - grid.getHeight() / 2.0f) * cellSize + offsetZ
-                );
-
-                // Render the pill
-                glm::mat4 model = glm::translate(glm::mat4(1.0f), worldPos);
-
-                // Apply scaling transformation to make the pill smaller
-                // Adjust the glm::vec3 values to scale the pill to the desired size
-                model = glm::scale(model, glm::vec3(0.5f, 0.5f, 0.5f)); // Example: scale down to half size
-
-                glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-                glBindVertexArray(VAO);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
-            if(grid.getCellContent(x,y) == CellContent::Path){
-				glUniform3f(glGetUniformLocation(shaderProgram, "color"), 1.0f, 1.0f, 1.0f); // Set color to cyan for path
-				// Calculate world position with center offset
-				glm::vec3 worldPos = glm::vec3(
-					(x - grid.getWidth() / 2.0f) * cellSize + offsetX,
-					offsetY,
-					(y - grid.getHeight() / 2.0f) * cellSize + offsetZ
-				);
-
-				glm::mat4 model = glm::translate(glm::mat4(1.0f), worldPos);
-
-                model = glm::scale(model, glm::vec3(0.2f, 0.2f, 0.2f)); // Example: scale down to half size
-				glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-				glBindVertexArray(VAO);
-				glDrawArrays(GL_TRIANGLES, 0, 36);
-			}
-            
-			
-        }
+    // Only the cells holding each content are visited, not the whole board
+    syncDrawLists();
+    glUniform3f(glGetUniformLocation(shaderProgram, "color"), 1.0f, 0.0f, 0.0f); // Set color to red for obstacles
+    for (int cell : obstacleCells) {
+        int x = cell % grid.getWidth();
+        int y = cell / grid.getWidth();
+
+        // Calculate world position with center offset
+        glm::vec3 worldPos = glm::vec3(
+            (x - grid.getWidth() / 2.0f) * cellSize + offsetX,
+            offsetY,
+            (y - grid.getHeight() / 2.0f) * cellSize + offsetZ
+        );
+
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), worldPos);
+        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+
+    glUniform3f(glGetUniformLocation(shaderProgram, "color"), 0.0f, 0.0f, 1.0f); // Set color to blue for pill
+    for (int cell : pillCells) {
+        int x = cell % grid.getWidth();
+        int y = cell / grid.getWidth();
+
+        // Calculate world position with center offset
+        glm::vec3 worldPos = glm::vec3(
+            (x - grid.getWidth() / 2.0f) * cellSize + offsetX,
+            offsetY,
+            (y - grid.getHeight() / 2.0f) * cellSize + offsetZ
+        );
+
+        // Render the pill
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), worldPos);
+
+        // Apply scaling transformation to make the pill smaller
+        // Adjust the glm::vec3 values to scale the pill to the desired size
+        model = glm::scale(model, glm::vec3(0.5f, 0.5f, 0.5f)); // Example: scale down to half size
+
+        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+
+    // Render the path overlay straight from the snake's route; it is not part of the grid's contents
+    glUniform3f(glGetUniformLocation(shaderProgram, "color"), 1.0f, 1.0f, 1.0f); // Set color to white for path
+    for (int cell : snake.getPath()) {
+        int x = cell % grid.getWidth();
+        int y = cell / grid.getWidth();
+        if (grid.getCellContent(x, y) == CellContent::Pill) continue;
+
+        // Calculate world position with center offset
+        glm::vec3 worldPos = glm::vec3(
+            (x - grid.getWidth() / 2.0f) * cellSize + offsetX,
+            offsetY,
+            (y - grid.getHeight() / 2.0f) * cellSize + offsetZ
+        );
+
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), worldPos);
+
+        model = glm::scale(model, glm::vec3(0.2f, 0.2f, 0.2f)); // Example: scale down to half size
+        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+
+}
+
+void Game::drawCube(const glm::vec3& position, float scale) {
+    glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(scale));
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
+    glBindVertexArray(VAO);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+}
+
+// The voxel arena: one cube per cell, centred on the origin in x and z and standing on the floor grid.
+// The camera pulls back with the arena's size so the whole volume stays in view.
+void Game::renderVoxels() {
+    float size = static_cast<float>(voxelGrid->getSizeX());
+    viewMatrix = glm::lookAt(glm::vec3(0.0f, 1.5f * size, 1.5f * size), glm::vec3(0.0f, size / 2.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    projectionMatrix = glm::perspective(glm::radians(60.0f), 800.0f / 600.0f, 0.1f, 100.0f + 4.0f * size);
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(viewMatrix));
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+
+    auto worldOf = [&](const Voxel& voxel) {
+        return glm::vec3(voxel.x - voxelGrid->getSizeX() / 2.0f + 0.5f, voxel.y + 0.5f, voxel.z - voxelGrid->getSizeZ() / 2.0f + 0.5f);
+    };
+
+    glUniform3f(glGetUniformLocation(shaderProgram, "color"), 0.0f, 1.0f, 0.0f); // Green snake
+    for (const Voxel& segment : voxelSnake->getBody()) {
+        drawCube(worldOf(segment), 1.0f);
+    }
+    glUniform3f(glGetUniformLocation(shaderProgram, "color"), 1.0f, 0.0f, 0.0f); // Red obstacles, drawn smaller to see through
+    for (const Voxel& obstacle : voxelObstacles) {
+        drawCube(worldOf(obstacle), 0.4f);
+    }
+    if (voxelSnake->hasPill()) {
+        glUniform3f(glGetUniformLocation(shaderProgram, "color"), 0.0f, 0.0f, 1.0f); // Blue pill
+        drawCube(worldOf(voxelSnake->getPill()), 0.5f);
     }
+}
 
+// The unbounded world, seen from above the head. Only the chunks around it are looked at, however far
+// the snake has roamed and however much it has left behind.
+void Game::renderWorld() {
+    const WorldCell& head = worldSnake->getBody().front();
+    glm::vec3 centre(static_cast<float>(head.x), 0.0f, static_cast<float>(head.y));
+    viewMatrix = glm::lookAt(centre + glm::vec3(0.0f, 25.0f, 20.0f), centre, glm::vec3(0.0f, 1.0f, 0.0f));
+    projectionMatrix = glm::perspective(glm::radians(60.0f), 800.0f / 600.0f, 0.1f, 200.0f);
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(viewMatrix));
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+
+    auto draw = [&](CellContent content, float r, float g, float b, float scale) {
+        glUniform3f(glGetUniformLocation(shaderProgram, "color"), r, g, b);
+        world->forEachCellIn(content, head.x - worldViewRadius, head.y - worldViewRadius, head.x + worldViewRadius, head.y + worldViewRadius,
+                             [&](int x, int y) { drawCube(glm::vec3(x + 0.5f, 0.5f, y + 0.5f), scale); });
+    };
+    draw(CellContent::Snake, 0.0f, 1.0f, 0.0f, 1.0f); // Green snake
+    draw(CellContent::Obstacle, 1.0f, 0.0f, 0.0f, 1.0f); // Red obstacles
+    draw(CellContent::Pill, 0.0f, 0.0f, 1.0f, 0.5f); // Blue pill
+}
 
+// Fill the obstacle and pill draw lists from scratch, with one scan of the board
+void Game::rebuildDrawLists() {
+    obstacleCells.reset(grid.getWidth() * grid.getHeight());
+    pillCells.reset(grid.getWidth() * grid.getHeight());
+    grid.forEachCell(CellContent::Obstacle, [&](int x, int y) { obstacleCells.insert(y * grid.getWidth() + x); });
+    grid.forEachCell(CellContent::Pill, [&](int x, int y) { pillCells.insert(y * grid.getWidth() + x); });
 }
 
+// Apply what changed on the grid since the last frame to the obstacle and pill draw lists.
+// If the journal overflowed, scan the board again instead.
+void Game::syncDrawLists() {
+    if (!grid.isJournalComplete()) {
+        rebuildDrawLists();
+        return;
+    }
+    for (const CellChange& change : grid.getChanges()) {
+        int cell = change.y * grid.getWidth() + change.x;
+        if (change.previous == CellContent::Obstacle) obstacleCells.erase(cell);
+        else if (change.previous == CellContent::Pill) pillCells.erase(cell);
+
+        if (change.current == CellContent::Obstacle) obstacleCells.insert(cell);
+        else if (change.current == CellContent::Pill) pillCells.insert(cell);
+    }
+}
 
 // Cleanup allocated resources: Called when closing the game to properly free resources.
 void Game::cleanup() {
@@ -406,7 +626,7 @@ void Game::toggleObstacleAt(int gridX, int gridY) {
         else {
             grid.setCellContent(gridX, gridY, CellContent::Obstacle);
         }
-        snake.calculateAndFollowPath();
+        // No replanning here: the edit bumps the grid version, so the next tick plans around it
     }
     else {
         // Log an error if the coordinates are out of bounds
@@ -416,8 +636,8 @@ void Game::toggleObstacleAt(int gridX, int gridY) {
 
 // Handles mouse button press events
 void Game::mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
-    // Check if the left mouse button was pressed
-    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
+    // Check if the left mouse button was pressed; clicks only edit the 2D board
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS && !gameInstance->voxelSnake && !gameInstance->worldSnake) {
 
         // Get the current mouse position
         double xpos, ypos;
@@ -434,6 +654,14 @@ void Game::mouseButtonCallback(GLFWwindow* window, int button, int action, int m
     }
 }
 
+void Game::setTickRate(double ticksPerSecond) {
+    if (!std::isfinite(ticksPerSecond) || ticksPerSecond <= 0.0) {
+        std::cerr << "Ignoring invalid tick rate: " << ticksPerSecond << std::endl;
+        return;
+    }
+    tickRate = ticksPerSecond;
+}
+
 void Game::placePill() {
     grid.placePill();
 }
\ No newline at end of file
@@ -7,37 +7,83 @@
 #include <glm.hpp>
 #include <gtc/matrix_transform.hpp>
 #include <gtc/type_ptr.hpp>
+#include <memory>
 #include "Snake.h"
 #include "Grid.h"
+#include "VoxelGrid.h"
+#include "VoxelSnake.h"
+#include "ChunkedGrid.h"
+#include "WorldSnake.h"
 
 class Game {
 public:
-    Game();
+    // The seed drives pill placement: the same seed replays the same game.
+    // voxelSize > 0 plays in a voxelSize^3 arena instead of the board, moving in all three dimensions.
+    // openWorld plays on an unbounded plane instead, stored in chunks that only exist where there is content.
+    Game(bool headless, uint64_t seed, int voxelSize = 0, bool openWorld = false);
     ~Game();
     void run();
+    void runHeadless(long long ticks); // Steps the simulation flat out, with no window, and reports ticks per second
 
     void screenPosToGridPos(double xpos, double ypos, int& gridX, int& gridY);
     void toggleObstacleAt(int gridX, int gridY);
     static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
     void placePill();
+    // Play on a level file's board instead: its size, obstacles and pills, with the snake at its start.
+    // For the board mode only, before the game runs. False, with the board left as it was, if the file won't do.
+    bool loadLevel(const std::string& path);
+    // Store the board's contents as CellLayout says, starting the board over. For the board mode, before the game runs.
+    void setCellLayout(CellLayout layout);
+    void setTickRate(double ticksPerSecond); // Simulation speed, whatever the frame rate; must be positive and finite
+    void setPathStrategy(PathStrategy strategy) { snake.setPathStrategy(strategy); }
+    void setClusterSize(int size) { snake.setClusterSize(size); } // For the Hierarchical strategy
     static Game* gameInstance; // Add a static pointer to the Game instance
 
 private:
+    bool headless; // No window, GL context or GPU resources: only the simulation runs
+    uint64_t seed;
     GLFWwindow* window;
     GLuint VAO, VBO, shaderProgram;
+    Grid grid; // Declared before snake, which keeps a reference to it
     Snake snake;
-    Grid grid;
+
+    // 3D mode, only set up when a voxel size is given. The board above then sits unused.
+    std::unique_ptr<VoxelGrid> voxelGrid;
+    std::unique_ptr<VoxelSnake> voxelSnake; // Declared after voxelGrid, which it keeps a reference to
+    std::vector<Voxel> voxelObstacles; // To draw; the arena's obstacles never change
+    long long voxelTicks = 0;
+    const int ticksPerVoxelMove = 50; // Same pace as the board snake
+    const int voxelObstaclePercent = 3;
+
+    // Unbounded mode, only set up when asked for. The world fills in as pills and their obstacles are dropped.
+    std::unique_ptr<ChunkedGrid> world;
+    std::unique_ptr<WorldSnake> worldSnake; // Declared after world, which it keeps a reference to
+    const int worldViewRadius = 20; // Cells drawn around the head
 
     GLuint gridVAO, gridVBO; 
     const int gridSize = 10;
+    const int pillCount = 1; // Pills kept on the board at once; each one eaten is replaced
     glm::mat4 viewMatrix, projectionMatrix;
 
+    // The simulation advances in fixed ticks; frames draw whatever fraction of the next tick has elapsed
+    double tickRate = 60.0; // Ticks per second; the snake moves one cell every 50 ticks
+    const double maxFrameTime = 0.25; // Longer frames (a stall, a dragged window) are cut short instead of replayed
+
+    // Obstacle and pill cells to draw, kept in step with the grid through its change journal
+    IndexSet obstacleCells, pillCells;
+    void syncDrawLists();
+    void rebuildDrawLists(); // Rescan the grid, for when its change journal is incomplete
+
 
     void init();
     GLuint loadShader(const std::string& vertexPath, const std::string& fragmentPath);
     void setupCube();
+    void tick(); // One fixed step of the simulation
     void update();
-    void render();
+    void render(float alpha); // alpha: how far between the previous tick and the latest one to draw the snake
+    void renderVoxels();
+    void renderWorld();
+    void drawCube(const glm::vec3& position, float scale);
     void cleanup();
     void setupGrid();
 
@@ -1,171 +1,402 @@
 #include "Grid.h"
 #include <iostream>
 #include <cstdlib>
-#include <ctime>
 #include <string>
+#include <cmath>
+#include <algorithm>
 
-Grid::Grid(int width, int height) : width(width), height(height) {
-    cells = std::vector<std::vector<CellContent>>(height, std::vector<CellContent>(width, CellContent::Empty));
-    initializeNodes();
-    placePill();
-    std::cout << "Grid initialized with size " << width << "x" << height << std::endl;
-}
-
-void Grid::initializeNodes() {
-    nodes.resize(height, std::vector<Node>(width));
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            nodes[y][x] = Node(cells[y][x] != CellContent::Obstacle && cells[y][x] != CellContent::Snake, x, y);
-        }
+Grid::Grid(int width, int height, CellLayout layout, uint64_t seed) : layout(layout), width(width), height(height), random(seed) {
+    if (layout == CellLayout::BitPlanes) {
+        planes.resize(width, height);
     }
-}
-
-Grid::Node* Grid::getNode(int x, int y) {
-    // Ensure coordinates are rounded or adjusted to fit the grid's indexing system
-    // This might involve rounding x and y if they're floating-point in the snake's position
-    int gridX = std::round(x);
-    int gridY = std::round(y);
-
-    if (gridX >= 0 && gridX < width && gridY >= 0 && gridY < height) {
-        return &nodes[gridY][gridX];
+    else {
+        cells.assign(width * height, CellContent::Empty);
     }
-    return nullptr;
-}
 
-std::vector<Grid::Node*> Grid::getNeighbors(Node* node) {
-    std::vector<Node*> neighbors;
+    // Every cell starts out empty
+    freeCells.fill(width * height);
+    pills.resize(width, height);
 
-    // Positions of potential neighbors (left, right, above, below)
-    std::vector<std::pair<int, int>> offsets = {
-        {-1, 0}, // left
-        {1, 0},  // right
-        {0, -1}, // above
-        {0, 1}   // below
-    };
+    resizeSearchScratch();
+    placePill();
+}
 
-    for (auto& offset : offsets) {
-        int neighborX = node->x + offset.first;
-        int neighborY = node->y + offset.second;
+void Grid::resizeSearchScratch() {
+    searchCost.resize(width * height);
+    searchParent.resize(width * height);
+    searchStamps.resize(width * height);
+    jumpTablesBuilt = false;
+}
 
-        // Check if the neighbor is within grid bounds
-        if (neighborX >= 0 && neighborX < width && neighborY >= 0 && neighborY < height) {
-            neighbors.push_back(&nodes[neighborY][neighborX]);
-        }
-    }
+int Grid::getNeighbors(int cell, int neighbors[4]) const {
+    int x = cell % width;
+    int y = cell / width;
 
-    return neighbors;
+    // Left, right, above, below, when they are within grid bounds
+    int count = 0;
+    if (x > 0) neighbors[count++] = cell - 1;
+    if (x < width - 1) neighbors[count++] = cell + 1;
+    if (y > 0) neighbors[count++] = cell - width;
+    if (y < height - 1) neighbors[count++] = cell + width;
+    return count;
 }
 
 CellContent Grid::getCellContent(int x, int y) const
 {
     if (x >= 0 && x < width && y >= 0 && y < height) {
-		return cells[y][x];
+		return layout == CellLayout::BitPlanes ? planes.get(x, y) : cells[y * width + x];
 	}
 	return CellContent::Obstacle;
 }
 
 void Grid::setCellContent(int x, int y, CellContent content) {
     if (x >= 0 && x < width && y >= 0 && y < height) {
-        cells[y][x] = content;
-        nodes[y][x].walkable = (content != CellContent::Obstacle && content != CellContent::Snake);
+        CellContent previous = getCellContent(x, y);
+        if (previous != content && journaling && !journalOverflowed) {
+            if (static_cast<int>(changes.size()) < width * height) {
+                changes.push_back({ x, y, previous, content });
+            }
+            else {
+                journalOverflowed = true;
+                changes.clear();
+            }
+        }
+        if (previous == CellContent::Empty && content != CellContent::Empty) {
+            freeCells.erase(y * width + x);
+        }
+        else if (previous != CellContent::Empty && content == CellContent::Empty) {
+            freeCells.insert(y * width + x);
+        }
+        if (previous == CellContent::Pill && content != CellContent::Pill) {
+            pills.remove(y * width + x);
+        }
+        else if (previous != CellContent::Pill && content == CellContent::Pill) {
+            pills.add(y * width + x);
+        }
+
+        if (layout == CellLayout::BitPlanes) {
+            planes.set(x, y, content);
+        }
+        else {
+            cells[y * width + x] = content;
+        }
+
+        bool nowWalkable = isWalkableContent(content);
+        if (isWalkableContent(previous) != nowWalkable) {
+            version++;
+            if (jumpTablesBuilt) {
+                markJumpColumnsDirty(x);
+            }
+            for (GridListener* listener : listeners) {
+                listener->onWalkabilityChanged(x, y, nowWalkable);
+            }
+        }
     }
     else {
         std::cerr << "Attempted to access grid out of bounds: " << x << ", " << y << std::endl;
     }
 }
 
-void Grid::placePill() {
-    srand(static_cast<unsigned int>(time(nullptr))); // Seed for random number generation
-    int x, y;
-    do {
-        x = rand() % getWidth();
-        y = rand() % getHeight();
-    } while (getCellContent(x, y) != CellContent::Empty);
-    setCellContent(x, y, CellContent::Pill);
+void Grid::loadObstacles(const uint64_t* bits) {
+    // Same layout as the obstacle plane: a single copy
+    if (layout == CellLayout::BitPlanes) {
+        planes.assign(CellContent::Obstacle, bits);
+    }
+
+    // Byte contents and the free list, in one pass
+    bool bytes = layout == CellLayout::Bytes;
+    freeCells.fill(width * height, [&](int i) {
+        bool blocked = (bits[i >> 6] >> (i & 63)) & 1;
+        if (bytes) {
+            cells[i] = blocked ? CellContent::Obstacle : CellContent::Empty;
+        }
+        return !blocked;
+    });
+    pills.clear();
+
+    // Too much may have changed to report cell by cell: the journal falls back to a rescan, listeners rebuild
+    version++;
+    jumpTablesBuilt = false;
+    if (journaling) {
+        changes.clear();
+        journalOverflowed = true;
+    }
+    for (GridListener* listener : listeners) {
+        listener->onGridReset();
+    }
+}
+
+size_t Grid::getContentBytes() const {
+    return layout == CellLayout::BitPlanes ? planes.getMemoryBytes() : cells.capacity() * sizeof(CellContent);
+}
+
+size_t Grid::getMemoryBytes() const {
+    size_t scratch = searchCost.capacity() * sizeof(int) + searchParent.capacity() * sizeof(uint32_t) +
+                     searchStamps.getMemoryBytes() + openSet.getMemoryBytes();
+    size_t jumpTables = (jumpUp.capacity() + jumpDown.capacity() + dirtyJumpColumns.capacity()) * sizeof(int) + jumpColumnDirty.capacity();
+    return getContentBytes() + freeCells.getMemoryBytes() + pills.getMemoryBytes() + changes.capacity() * sizeof(CellChange) +
+           scratch + jumpTables;
+}
+
+void Grid::addListener(GridListener* listener) {
+    listeners.push_back(listener);
+}
+
+void Grid::removeListener(GridListener* listener) {
+    listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
 }
 
-int Grid::distanceBetweenNodes(Node* a, Node* b) const {
+bool Grid::placePill() {
+    if (freeCells.empty()) {
+        return false; // The board is full
+    }
+
+    // Every empty cell is in freeCells, so one draw is a uniform pick however crowded the board is
+    int cell = freeCells[random.below(static_cast<uint32_t>(freeCells.size()))];
+    setCellContent(cell % width, cell / width, CellContent::Pill);
+    return true;
+}
+
+int Grid::distanceBetweenCells(int a, int b) const {
     // Using Manhattan distance as the heuristic
-    int distanceX = std::abs(a->x - b->x);
-    int distanceY = std::abs(a->y - b->y);
+    int distanceX = std::abs(a % width - b % width);
+    int distanceY = std::abs(a / width - b / width);
     return distanceX + distanceY;
 }
 
 
-Position Grid::getPillPosition() const
+int Grid::getPillCell() const
 {
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            
-            if (cells[y][x] == CellContent::Pill) {
-				return Position(x, y);
-			}
-		}
-	}
-	return Position(-1, -1);
+    if (pills.size() == 0) {
+        return -1;
+    }
+    return pills.getCells().front();
 }
 
-std::vector<Grid::Node*> Grid::findPath(const Node& start, const Node& goal) {
-    Node* startNode = getNode(start.x, start.y);
-    Node* goalNode = getNode(goal.x, goal.y);
+int Grid::getNearestPill(int x, int y) const {
+    return pills.findNearest(x, y);
+}
 
-    std::vector<Node*> openSet;
-    std::vector<Node*> closedSet;
-    openSet.push_back(startNode);
+int Grid::countCells(CellContent content) const {
+    if (layout == CellLayout::BitPlanes) {
+        return planes.count(content);
+    }
+    return static_cast<int>(std::count(cells.begin(), cells.end(), content));
+}
+
+void Grid::beginSearch() {
+    openSet.clear();
+    openSet.reserve(width * height);
+
+    searchStamps.advance();
+}
 
+void Grid::touchCell(int index) {
+    if (searchStamps.touch(index)) {
+        searchCost[index] = std::numeric_limits<int>::max();
+        searchParent[index] = index;
+    }
+}
+
+bool Grid::isWalkable(int x, int y) const {
+    return x >= 0 && x < width && y >= 0 && y < height && isWalkableCell(y * width + x);
+}
+
+// Queue a cell reached from parent, keeping it only if this is a cheaper route than the one already known.
+// The heuristic is consistent, so an expanded cell already has its cheapest cost and is never queued again.
+void Grid::openCell(int cell, int parent, int goal) {
+    touchCell(cell);
+
+    int newCost = searchCost[parent] + distanceBetweenCells(parent, cell);
+    if (newCost < searchCost[cell]) {
+        searchCost[cell] = newCost;
+        searchParent[cell] = parent;
+
+        // Inserts the cell, or decreases its key if it is already open
+        int hCost = distanceBetweenCells(cell, goal);
+        openSet.push(cell, { newCost + hCost, hCost });
+    }
+}
+
+std::vector<int> Grid::findPath(int startX, int startY, int goalX, int goalY, PathAlgorithm algorithm) {
+    std::vector<int> path;
+    findPath(startX, startY, goalX, goalY, path, algorithm);
+    return path;
+}
+
+bool Grid::findPath(int startX, int startY, int goalX, int goalY, std::vector<int>& path, PathAlgorithm algorithm) {
+    path.clear();
+    lastExpandedNodes = 0;
+    if (!isInside(startX, startY) || !isInside(goalX, goalY)) {
+        return false;
+    }
+    int start = startY * width + startX;
+    int goal = goalY * width + goalX;
+
+    if (algorithm == PathAlgorithm::JumpPoint) {
+        updateJumpTables();
+    }
+    beginSearch();
+    touchCell(start);
+    searchCost[start] = 0;
+    int startHCost = distanceBetweenCells(start, goal);
+    openSet.push(start, { startHCost, startHCost });
+
+    int neighbors[4];
     while (!openSet.empty()) {
-        Node* currentNode = openSet[0];
-        for (int i = 1; i < openSet.size(); i++) {
-            if (openSet[i]->fCost() < currentNode->fCost() || (openSet[i]->fCost() == currentNode->fCost() && openSet[i]->hCost < currentNode->hCost)) {
-                currentNode = openSet[i];
-            }
+        // Lowest fCost first, ties broken on the lowest hCost
+        int current = openSet.pop();
+        lastExpandedNodes++;
+
+        if (current == goal) {
+            buildPath(start, goal, path);
+            return true;
         }
 
-        openSet.erase(std::remove(openSet.begin(), openSet.end(), currentNode), openSet.end());
-        closedSet.push_back(currentNode);
+        if (algorithm == PathAlgorithm::JumpPoint) {
+            expandJumpPoints(current, start, goal);
+            continue;
+        }
 
-        if (currentNode == goalNode) {
-            std::vector<Node*> path;
-            while (currentNode != nullptr && currentNode != startNode) {
-                path.push_back(currentNode);
-                currentNode = currentNode->parent;
-            }
-            std::reverse(path.begin(), path.end());
-
-            for (int i = 0; i < getHeight(); i++) {
-                for (int j = 0; j < getWidth(); j++) {
-                    if (getCellContent(j, i) == CellContent::Path) {
-                        setCellContent(j, i, CellContent::Empty);
-                    }
-                }
+        int count = getNeighbors(current, neighbors);
+        for (int i = 0; i < count; ++i) {
+            if (isWalkableCell(neighbors[i])) {
+                openCell(neighbors[i], current, goal);
             }
+        }
+    }
 
-            for (auto& node : path) {
-                if (getCellContent(node->x, node->y) != CellContent::Pill) {
-                    setCellContent(node->x, node->y, CellContent::Path);
-                }
-            }
-            return path;
+
+    return false; // Leave the path empty if no path is found
+}
+
+// Walk the parent links back from the goal. Jump point parents can be several cells away
+// in a straight line, so the cells in between are filled in to give a step-by-step path.
+void Grid::buildPath(int start, int goal, std::vector<int>& path) {
+    int current = goal;
+    while (current != start) {
+        int parent = static_cast<int>(searchParent[current]);
+        int step = 0;
+        if (parent / width != current / width) {
+            step = parent > current ? width : -width;
         }
+        else {
+            step = parent > current ? 1 : -1;
+        }
+        for (int cell = current; cell != parent; cell += step) {
+            path.push_back(cell);
+        }
+        current = parent;
+    }
+    std::reverse(path.begin(), path.end());
+}
+
+// Jump Point Search for 4-connected moves. Paths are made canonical by allowing a vertical move after
+// a horizontal one, but a horizontal move after a vertical one only when an obstacle forces it.
+// Every other route of the same length is skipped, so only the jump points end up in the open set.
+void Grid::expandJumpPoints(int cell, int start, int goal) {
+    int directions[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+    int x = cell % width;
+    int y = cell / width;
+    int dirX = 0, dirY = 0;
+    if (cell != start) {
+        int parent = static_cast<int>(searchParent[cell]);
+        int parentX = parent % width;
+        int parentY = parent / width;
+        dirX = (x > parentX) - (x < parentX);
+        dirY = (y > parentY) - (y < parentY);
+    }
 
-        for (Node* neighbor : getNeighbors(currentNode)) {
-            if (std::find(closedSet.begin(), closedSet.end(), neighbor) != closedSet.end() || !neighbor->walkable) {
-                continue;
+    for (auto& direction : directions) {
+        int dx = direction[0];
+        int dy = direction[1];
+        if (cell != start) {
+            if (dx == -dirX && dy == -dirY) continue; // Never go back the way we came
+            if (dirY != 0 && dx != 0) {
+                // Arrived vertically: turning sideways is only needed around an obstacle
+                bool forced = isWalkable(x + dx, y) && !isWalkable(x + dx, y - dirY);
+                if (!forced) continue;
             }
+        }
 
-            int newCostToNeighbor = currentNode->gCost + distanceBetweenNodes(currentNode, neighbor);
-            if (newCostToNeighbor < neighbor->gCost || std::find(openSet.begin(), openSet.end(), neighbor) == openSet.end()) {
-                neighbor->gCost = newCostToNeighbor;
-                neighbor->hCost = distanceBetweenNodes(neighbor, goalNode);
-                neighbor->parent = currentNode;
+        int jumpPoint = (dx != 0) ? jumpHorizontal(x, y, dx, goal) : jumpVertical(x, y, dy, goal);
+        if (jumpPoint >= 0) {
+            openCell(jumpPoint, cell, goal);
+        }
+    }
+}
 
-                if (std::find(openSet.begin(), openSet.end(), neighbor) == openSet.end()) {
-                    openSet.push_back(neighbor);
-                }
-            }
+int Grid::jumpHorizontal(int x, int y, int dx, int goal) {
+    while (true) {
+        x += dx;
+        if (!isWalkable(x, y)) return -1;
+
+        int cell = y * width + x;
+        if (cell == goal) return cell;
+
+        // Every cell of a horizontal run may branch vertically, so it is a jump point if a branch finds one
+        if (jumpVertical(x, y, -1, goal) >= 0 || jumpVertical(x, y, 1, goal) >= 0) {
+            return cell;
         }
     }
+}
 
+// Vertical runs come from the jump tables: only the goal, which the tables know nothing of, is checked here
+int Grid::jumpVertical(int x, int y, int dy, int goal) {
+    int stop = dy < 0 ? jumpUp[y * width + x] : jumpDown[y * width + x];
+    int goalX = goal % width;
+    int goalSteps = (goal / width - y) * dy;
+    if (goalX == x && goalSteps > 0 && (stop > 0 ? goalSteps <= stop : goalSteps < -stop)) {
+        return goal;
+    }
+    return stop > 0 ? (y + stop * dy) * width + x : -1;
+}
 
-    return {}; // Return empty path if no path is found
-}
\ No newline at end of file
+void Grid::markJumpColumnsDirty(int x) {
+    for (int column = std::max(x - 1, 0); column <= std::min(x + 1, width - 1); ++column) {
+        if (!jumpColumnDirty[column]) {
+            jumpColumnDirty[column] = 1;
+            dirtyJumpColumns.push_back(column);
+        }
+    }
+}
+
+void Grid::updateJumpTables() {
+    if (!jumpTablesBuilt) {
+        jumpUp.resize(width * height);
+        jumpDown.resize(width * height);
+        jumpColumnDirty.assign(width, 0);
+        dirtyJumpColumns.clear();
+        dirtyJumpColumns.reserve(width);
+        for (int x = 0; x < width; ++x) {
+            rebuildJumpColumn(x);
+        }
+        jumpTablesBuilt = true;
+        return;
+    }
+    for (int x : dirtyJumpColumns) {
+        rebuildJumpColumn(x);
+        jumpColumnDirty[x] = 0;
+    }
+    dirtyJumpColumns.clear();
+}
+
+// Each direction is one sweep against it: a cell's entry follows from the entry of the cell it steps into.
+// A vertical jump stops where a side cell that was blocked one step back opens up, since the path may turn there.
+void Grid::rebuildJumpColumn(int x) {
+    auto turns = [&](int y, int dy) {
+        return (isWalkable(x - 1, y) && !isWalkable(x - 1, y - dy)) || (isWalkable(x + 1, y) && !isWalkable(x + 1, y - dy));
+    };
+    auto stepFrom = [&](int next, int dy, const std::vector<int>& table) {
+        if (!isWalkable(x, next)) return -1;
+        if (turns(next, dy)) return 1;
+        int stop = table[next * width + x];
+        return stop > 0 ? stop + 1 : stop - 1;
+    };
+    for (int y = height - 1; y >= 0; --y) {
+        jumpDown[y * width + x] = stepFrom(y + 1, 1, jumpDown);
+    }
+    for (int y = 0; y < height; ++y) {
+        jumpUp[y * width + x] = stepFrom(y - 1, -1, jumpUp);
+    }
+}
@@ -2,45 +2,154 @@
 #define GRID_H
 
 #include <vector>
+#include <cstdint>
 #include "CellContent.h"
 #include <limits>
-#include "Snake.h"
+#include <utility>
+#include "IndexedHeap.h"
+#include "CellPlanes.h"
+#include "PillRegistry.h"
+#include "Random.h"
+#include "IndexSet.h"
+#include "EpochStamps.h"
 
-class Grid {
-public:
-    struct Node {
-        bool walkable;
-        int gCost, hCost;
-        Node* parent;
-        int x, y; // Position in the grid
+// Search strategy used by Grid::findPath
+enum class PathAlgorithm {
+    AStar,     // Plain A* over the 4 neighbors of each cell
+    JumpPoint  // Jump Point Search: same path lengths, far fewer expanded nodes; vertical jumps are table lookups
+};
+
+// How Grid stores cell contents
+enum class CellLayout {
+    Bytes,    // One CellContent per cell
+    BitPlanes // One bit per cell for each content type (see CellPlanes): smaller, and fast bulk queries.
+              // Walkability is read from the Snake and Obstacle planes, so the contents cost 3 bits per cell.
+};
 
-        Node(bool walkable = true, int x = 0, int y = 0) : walkable(walkable), gCost(std::numeric_limits<int>::max()), hCost(0), parent(nullptr), x(x), y(y) {}
+// Implemented by anything that keeps derived state about the grid (planners, caches).
+// Grid::setCellContent calls it whenever a cell switches between walkable and blocked.
+class GridListener {
+public:
+    virtual ~GridListener() = default;
+    virtual void onWalkabilityChanged(int x, int y, bool walkable) = 0;
+    virtual void onGridReset() = 0; // Every cell may have changed at once: rebuild from scratch
+};
 
-        int fCost() const { return gCost + hCost; }
-        bool isInPath() const { return walkable && parent != nullptr; }
-    };
+// One entry of Grid's change journal
+struct CellChange {
+    int x, y;
+    CellContent previous, current;
+};
 
+class Grid {
+public:
     Grid() = default;
-    Grid(int width, int height);
-    void initializeNodes(); // Initialize the nodes based on cells
+    // The seed drives pill placement; the same seed and the same moves replay the same game
+    Grid(int width, int height, CellLayout layout = CellLayout::Bytes, uint64_t seed = 0);
 
     CellContent getCellContent(int x, int y) const;
     void setCellContent(int x, int y, CellContent content);
-    Node* getNode(int x, int y); // Get the node at a specific position
-    std::vector<Node*> getNeighbors(Node* node); // Get neighbors of a node
-    void placePill();
+    // Replace the whole board in one pass: cells whose bit is set (one bit per cell, row-major, in 64-bit words,
+    // like a CellPlanes plane) become obstacles, every other cell Empty. Pills and snake cells are cleared.
+    void loadObstacles(const uint64_t* bits);
+    bool isInside(int x, int y) const { return x >= 0 && x < width && y >= 0 && y < height; }
+    int getNeighbors(int cell, int neighbors[4]) const; // Cells next to cell (index y * width + x); returns how many there are
+    bool placePill(); // Puts a pill on a random empty cell; false if there is none
     int getWidth() const { return width; }
     int getHeight() const { return height; }
-    Position getPillPosition() const;
+    int getPillCell() const; // One of the pills as a cell index (y * width + x), -1 if there are none
+    int getNearestPill(int x, int y) const; // Cell index of the pill closest to (x, y), -1 if there are none
+    int getPillCount() const { return pills.size(); }
+    int countCells(CellContent content) const; // Cells currently holding content
+    // Every content change since the last clearChanges, oldest first. Consumers that mirror the board read
+    // this instead of rescanning it; the owner of the frame loop clears it once everybody has had a look.
+    // Off until a consumer turns it on. It holds at most one entry per cell: past that a rescan is no dearer,
+    // so recording stops and isJournalComplete() turns false until the next clearChanges.
+    void setJournaling(bool enabled) { journaling = enabled; clearChanges(); }
+    const std::vector<CellChange>& getChanges() const { return changes; }
+    bool isJournalComplete() const { return !journalOverflowed; }
+    void clearChanges() { changes.clear(); journalOverflowed = false; }
+    void reseed(uint64_t seed) { random.reseed(seed); }
+    int getFreeCellCount() const { return freeCells.size(); } // Empty cells
+    CellLayout getLayout() const { return layout; }
+    size_t getContentBytes() const; // Heap held by the cell contents alone: the CellContent bytes or the planes
+    size_t getMemoryBytes() const; // Heap held by the whole board: contents, free-cell and pill indexes, search scratch
+
+    // Calls visit(x, y) for every cell holding content, in row-major order; same result with either layout
+    template <typename Visit>
+    void forEachCell(CellContent content, Visit visit) const {
+        if (layout == CellLayout::BitPlanes) {
+            planes.forEach(content, visit);
+            return;
+        }
+        for (int i = 0; i < width * height; ++i) {
+            if (cells[i] == content) {
+                visit(i % width, i / width);
+            }
+        }
+    }
+    bool isWalkable(int x, int y) const; // Neither an obstacle nor the snake's body; false outside the grid
+    unsigned int getVersion() const { return version; } // Bumped by every change of walkability
+
+    void addListener(GridListener* listener);
+    void removeListener(GridListener* listener);
 
-    std::vector<Node*> findPath(const Node& start, const Node& goal);
+    // Paths are cell indices (y * width + x), start excluded, goal included
+    std::vector<int> findPath(int startX, int startY, int goalX, int goalY, PathAlgorithm algorithm = PathAlgorithm::AStar);
+    // Same search, writing into a caller-owned path whose storage is reused.
+    // With the path's capacity warmed up, a query does no heap allocation. Returns false if there is no path.
+    bool findPath(int startX, int startY, int goalX, int goalY, std::vector<int>& path, PathAlgorithm algorithm = PathAlgorithm::AStar);
+    int getLastExpandedNodes() const { return lastExpandedNodes; } // Nodes taken off the open set by the last findPath
 
 private:
 
-    int distanceBetweenNodes(Node* a, Node* b) const; // Helper method for A*
-    std::vector<std::vector<CellContent>> cells;
-    std::vector<std::vector<Node>> nodes; // Added nodes representation
+    static bool isWalkableContent(CellContent content) { return content != CellContent::Obstacle && content != CellContent::Snake; }
+    bool isWalkableCell(int cell) const { // Same as isWalkable, for a cell known to be inside
+        return layout == CellLayout::BitPlanes ? !planes.isBlocked(cell) : isWalkableContent(cells[cell]);
+    }
+    void resizeSearchScratch();
+    int distanceBetweenCells(int a, int b) const; // Helper method for A*
+    void beginSearch(); // Start a new search epoch: every cell's scratch becomes stale in O(1)
+    void touchCell(int index); // Reset a cell's search scratch if it was written by an older search
+    void openCell(int cell, int parent, int goal);
+    void buildPath(int start, int goal, std::vector<int>& path);
+    void expandJumpPoints(int cell, int start, int goal);
+    int jumpHorizontal(int x, int y, int dx, int goal); // Jump point found, -1 if none
+    int jumpVertical(int x, int y, int dy, int goal);
+    void updateJumpTables(); // Bring the jump tables up to date before a jump point search
+    void rebuildJumpColumn(int x);
+    void markJumpColumnsDirty(int x); // Column x changed walkability: it and its two neighbors need a rebuild
+
+    // Row-major, one contiguous buffer each: cell (x, y) lives at y * width + x
+    CellLayout layout = CellLayout::Bytes;
+    std::vector<CellContent> cells; // Only used by the Bytes layout
+    CellPlanes planes; // Only used by the BitPlanes layout
     int width, height;
+
+    // Search scratch, one array per field indexed like the cells, so the hot loops touch only what they use
+    std::vector<int> searchCost; // Cost of the best known route from the start
+    std::vector<uint32_t> searchParent; // Cell that route came from; the start is its own parent
+    EpochStamps searchStamps; // Which cells' scratch was written by the current search
+    int lastExpandedNodes = 0;
+    std::vector<GridListener*> listeners;
+    unsigned int version = 0;
+
+    IndexSet freeCells; // The empty cells, kept up to date by setCellContent: O(1) insert, remove and uniform pick
+    Random random; // Used to place pills
+    PillRegistry pills;
+    std::vector<CellChange> changes;
+    bool journaling = false;
+    bool journalOverflowed = false;
+    IndexedHeap<std::pair<int, int>> openSet; // A* open set keyed by (fCost, hCost), kept to reuse its storage
+
+    // Jump point search tables, built by the first JumpPoint query. For each cell, the steps up (jumpUp) or down
+    // (jumpDown) its column to where a vertical jump stops: positive for a cell where the path may turn, negative
+    // for the obstacle or edge that ends the run. A walkability change only marks the columns it affects;
+    // they are rebuilt by the next JumpPoint query.
+    std::vector<int> jumpUp, jumpDown;
+    std::vector<unsigned char> jumpColumnDirty;
+    std::vector<int> dirtyJumpColumns;
+    bool jumpTablesBuilt = false;
 };
 
 #endif // GRID_H
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include "GridSnapshot.h"
+#include <algorithm>
+
+GridSnapshot::GridSnapshot(const Grid& grid)
+    : grid(&grid), width(grid.getWidth()), height(grid.getHeight()) {
+    chunksX = (width + chunkSize - 1) / chunkSize;
+}
+
+GridSnapshot::GridSnapshot(const GridSnapshot* parent)
+    : parent(parent), width(parent->width), height(parent->height), chunksX(parent->chunksX) {
+}
+
+CellContent GridSnapshot::getCellContent(int x, int y) const {
+    if (x < 0 || x >= width || y < 0 || y >= height) {
+        return CellContent::Obstacle;
+    }
+    auto found = chunks.find(chunkOf(x, y));
+    if (found != chunks.end()) {
+        return found->second[offsetInChunk(x, y)];
+    }
+    return readThrough(x, y);
+}
+
+CellContent GridSnapshot::readThrough(int x, int y) const {
+    return parent != nullptr ? parent->getCellContent(x, y) : grid->getCellContent(x, y);
+}
+
+void GridSnapshot::setCellContent(int x, int y, CellContent content) {
+    if (x < 0 || x >= width || y < 0 || y >= height) {
+        return;
+    }
+
+    int chunk = chunkOf(x, y);
+    auto found = chunks.find(chunk);
+    if (found == chunks.end()) {
+        // First write into this chunk: copy it from the parent, then write into the copy
+        std::vector<CellContent> cells(chunkSize * chunkSize, CellContent::Obstacle);
+        int originX = (x / chunkSize) * chunkSize;
+        int originY = (y / chunkSize) * chunkSize;
+        int endX = std::min(originX + chunkSize, width);
+        int endY = std::min(originY + chunkSize, height);
+        for (int cellY = originY; cellY < endY; ++cellY) {
+            for (int cellX = originX; cellX < endX; ++cellX) {
+                cells[offsetInChunk(cellX, cellY)] = readThrough(cellX, cellY);
+            }
+        }
+        found = chunks.emplace(chunk, std::move(cells)).first;
+    }
+    found->second[offsetInChunk(x, y)] = content;
+}
+
+bool GridSnapshot::isWalkable(int x, int y) const {
+    CellContent content = getCellContent(x, y);
+    return content != CellContent::Obstacle && content != CellContent::Snake;
+}
+
+void GridSnapshot::revert() {
+    chunks.clear();
+}
@@ -0,0 +1,41 @@
+#ifndef GRID_SNAPSHOT_H
+#define GRID_SNAPSHOT_H
+
+#include <vector>
+#include <unordered_map>
+#include "Grid.h"
+
+// Copy-on-write view of a Grid for speculative simulation (try a move sequence, see if the snake gets
+// trapped, throw it away). Forking is O(1): nothing is copied until a cell is written, and then only the
+// small square chunk holding it. Reads fall through to the parent for every chunk that wasn't touched,
+// so a rollout costs what it changes. Snapshots can be forked from snapshots to branch further.
+// The parent (grid or snapshot) must outlive its forks and must not change while they are in use.
+class GridSnapshot {
+public:
+    static const int chunkSize = 16;
+
+    explicit GridSnapshot(const Grid& grid); // Fork off the live grid
+    explicit GridSnapshot(const GridSnapshot* parent); // Fork off another snapshot
+
+    CellContent getCellContent(int x, int y) const; // Obstacle outside the board, like Grid
+    void setCellContent(int x, int y, CellContent content);
+    bool isWalkable(int x, int y) const;
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    int getCopiedChunkCount() const { return static_cast<int>(chunks.size()); }
+    void revert(); // Drop every change, back to the parent's state
+
+private:
+    const Grid* grid = nullptr;
+    const GridSnapshot* parent = nullptr;
+    int width, height;
+    int chunksX;
+    std::unordered_map<int, std::vector<CellContent>> chunks; // Chunks written since the fork
+
+    int chunkOf(int x, int y) const { return (y / chunkSize) * chunksX + x / chunkSize; }
+    static int offsetInChunk(int x, int y) { return (y % chunkSize) * chunkSize + x % chunkSize; }
+    CellContent readThrough(int x, int y) const; // Content as the parent sees it
+};
+
+#endif // GRID_SNAPSHOT_H
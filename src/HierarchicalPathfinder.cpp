@@ -0,0 +1,459 @@
+#include "HierarchicalPathfinder.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    const int neighborOffsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+    const int maxSingleTransitionWidth = 5; // Wider openings get one transition at each end
+}
+
+HierarchicalPathfinder::HierarchicalPathfinder(Grid& grid, int clusterSize) : grid(grid), clusterSize(clusterSize) {
+    grid.addListener(this);
+}
+
+HierarchicalPathfinder::~HierarchicalPathfinder() {
+    grid.removeListener(this);
+}
+
+void HierarchicalPathfinder::onWalkabilityChanged(int x, int y, bool) {
+    if (clusters.empty()) {
+        return; // Nothing built yet, the first query builds everything
+    }
+
+    int clusterIndex = clusterOf(x, y);
+    markDirty(clusterIndex);
+    loadedCluster = -1;
+
+    // A cell on a cluster border also decides the entrances of the cluster on the other side
+    const Cluster& cluster = clusters[clusterIndex];
+    if (x == cluster.minX && x > 0) markDirty(clusterOf(x - 1, y));
+    if (x == cluster.maxX && x < width - 1) markDirty(clusterOf(x + 1, y));
+    if (y == cluster.minY && y > 0) markDirty(clusterOf(x, y - 1));
+    if (y == cluster.maxY && y < height - 1) markDirty(clusterOf(x, y + 1));
+}
+
+void HierarchicalPathfinder::onGridReset() {
+    // A size mismatch makes the next query rebuild every cluster
+    clusters.clear();
+    routeGoal = -1;
+    width = 0;
+    height = 0;
+}
+
+void HierarchicalPathfinder::markDirty(int clusterIndex) {
+    clusters[clusterIndex].dirty = true;
+}
+
+void HierarchicalPathfinder::resize() {
+    width = grid.getWidth();
+    height = grid.getHeight();
+    clustersX = (width + clusterSize - 1) / clusterSize;
+    clustersY = (height + clusterSize - 1) / clusterSize;
+    nodesPerCluster = 4 * clusterSize + 4;
+
+    clusters.assign(clustersX * clustersY, Cluster());
+    routeGoal = -1;
+    for (int cy = 0; cy < clustersY; ++cy) {
+        for (int cx = 0; cx < clustersX; ++cx) {
+            Cluster& cluster = clusters[cy * clustersX + cx];
+            cluster.minX = cx * clusterSize;
+            cluster.minY = cy * clusterSize;
+            cluster.maxX = std::min(cluster.minX + clusterSize, width) - 1;
+            cluster.maxY = std::min(cluster.minY + clusterSize, height) - 1;
+        }
+    }
+
+    // Extra ids for the start and goal of a query, and for the start's neighbors in other clusters
+    int abstractIds = static_cast<int>(clusters.size()) * nodesPerCluster + 6;
+    gCost.assign(abstractIds, 0);
+    parent.assign(abstractIds, -1);
+    stamps.resize(abstractIds);
+    open.clear();
+    open.reserve(abstractIds);
+
+    localWalkable.assign(clusterSize * clusterSize, false);
+    loadedCluster = -1;
+    localDistance.assign(clusterSize * clusterSize, -1);
+    localParent.assign(clusterSize * clusterSize, -1);
+    localQueue.reserve(clusterSize * clusterSize);
+}
+
+const HierarchicalPathfinder::Cluster& HierarchicalPathfinder::builtCluster(int clusterIndex) {
+    if (clusters[clusterIndex].dirty) {
+        rebuildCluster(clusterIndex);
+    }
+    return clusters[clusterIndex];
+}
+
+void HierarchicalPathfinder::rebuildCluster(int clusterIndex) {
+    Cluster& cluster = clusters[clusterIndex];
+    cluster.nodeCells.clear();
+    cluster.partnerCells.clear();
+    cluster.edgeStart.clear();
+    cluster.edges.clear();
+    cluster.dirty = false;
+
+    // Entrances on each border that has a cluster behind it
+    if (cluster.minX > 0) addTransitions(cluster, cluster.minX, cluster.minY, cluster.minX, cluster.maxY, 0, 1, -1, 0);
+    if (cluster.maxX < width - 1) addTransitions(cluster, cluster.maxX, cluster.minY, cluster.maxX, cluster.maxY, 0, 1, 1, 0);
+    if (cluster.minY > 0) addTransitions(cluster, cluster.minX, cluster.minY, cluster.maxX, cluster.minY, 1, 0, 0, -1);
+    if (cluster.maxY < height - 1) addTransitions(cluster, cluster.minX, cluster.maxY, cluster.maxX, cluster.maxY, 1, 0, 0, 1);
+
+    // Distances between every pair of entrances, staying inside the cluster
+    for (int node = 0; node < cluster.nodeCount(); ++node) {
+        cluster.edgeStart.push_back(static_cast<int>(cluster.edges.size()));
+        searchCluster(cluster, cluster.nodeCells[node]);
+        for (int target = 0; target < cluster.nodeCount(); ++target) {
+            int distance = distanceInCluster(cluster, cluster.nodeCells[target]);
+            if (target != node && distance >= 0) {
+                cluster.edges.push_back(Edge{ target, distance });
+            }
+        }
+    }
+    cluster.edgeStart.push_back(static_cast<int>(cluster.edges.size()));
+}
+
+// Walk one border line and turn every opening (cells walkable on both sides) into entrances.
+// Both clusters sharing the border scan the same two lines, so they agree on where the entrances are.
+void HierarchicalPathfinder::addTransitions(Cluster& cluster, int fromX, int fromY, int toX, int toY, int stepX, int stepY, int acrossX, int acrossY) {
+    int runStart = -1;
+    int length = std::max(toX - fromX, toY - fromY) + 1;
+    for (int i = 0; i <= length; ++i) {
+        int x = fromX + stepX * i;
+        int y = fromY + stepY * i;
+        bool open = i < length && grid.isWalkable(x, y) && grid.isWalkable(x + acrossX, y + acrossY);
+
+        if (open && runStart < 0) {
+            runStart = i;
+        }
+        else if (!open && runStart >= 0) {
+            int runEnd = i - 1;
+            int picks[2] = { (runStart + runEnd) / 2, -1 };
+            if (runEnd - runStart + 1 > maxSingleTransitionWidth) {
+                picks[0] = runStart;
+                picks[1] = runEnd;
+            }
+            for (int pick : picks) {
+                if (pick >= 0) {
+                    int cellX = fromX + stepX * pick;
+                    int cellY = fromY + stepY * pick;
+                    addEntrance(cluster, cellY * width + cellX, (cellY + acrossY) * width + cellX + acrossX);
+                }
+            }
+            runStart = -1;
+        }
+    }
+}
+
+void HierarchicalPathfinder::addEntrance(Cluster& cluster, int cell, int partnerCell) {
+    // A corner cell can be an entrance on two borders at once
+    for (int node = 0; node < cluster.nodeCount(); ++node) {
+        if (cluster.nodeCells[node] == cell) {
+            int* partners = &cluster.partnerCells[node * maxPartners];
+            int slot = 0;
+            while (slot < maxPartners - 1 && partners[slot] >= 0) {
+                slot++;
+            }
+            partners[slot] = partnerCell;
+            return;
+        }
+    }
+    if (cluster.nodeCount() < nodesPerCluster) {
+        cluster.nodeCells.push_back(cell);
+        cluster.partnerCells.push_back(partnerCell);
+        cluster.partnerCells.insert(cluster.partnerCells.end(), maxPartners - 1, -1);
+    }
+}
+
+int HierarchicalPathfinder::findNode(int cell) const {
+    int clusterIndex = clusterOf(cell % width, cell / width);
+    const Cluster& cluster = clusters[clusterIndex];
+    for (int node = 0; node < cluster.nodeCount(); ++node) {
+        if (cluster.nodeCells[node] == cell) {
+            return clusterIndex * nodesPerCluster + node;
+        }
+    }
+    return -1;
+}
+
+int HierarchicalPathfinder::localIndex(const Cluster& cluster, int cell) const {
+    return (cell / width - cluster.minY) * clusterSize + (cell % width - cluster.minX);
+}
+
+int HierarchicalPathfinder::distanceInCluster(const Cluster& cluster, int cell) const {
+    return localDistance[localIndex(cluster, cell)];
+}
+
+// Copy the cluster's walkability into a small local array, so the searches inside it stay cache-local
+void HierarchicalPathfinder::loadCluster(const Cluster& cluster) {
+    int clusterIndex = clusterOf(cluster.minX, cluster.minY);
+    if (loadedCluster == clusterIndex) {
+        return;
+    }
+    for (int y = cluster.minY; y <= cluster.maxY; ++y) {
+        for (int x = cluster.minX; x <= cluster.maxX; ++x) {
+            localWalkable[(y - cluster.minY) * clusterSize + (x - cluster.minX)] = grid.isWalkable(x, y);
+        }
+    }
+    loadedCluster = clusterIndex;
+}
+
+void HierarchicalPathfinder::searchCluster(const Cluster& cluster, int sourceCell, int stopCell) {
+    loadCluster(cluster);
+    int sizeX = cluster.maxX - cluster.minX + 1;
+    int sizeY = cluster.maxY - cluster.minY + 1;
+    for (int y = 0; y < sizeY; ++y) {
+        std::fill_n(localDistance.begin() + y * clusterSize, sizeX, -1);
+    }
+
+    // The source itself may be blocked (the snake's head is), every other cell must be walkable
+    int source = localIndex(cluster, sourceCell);
+    int stop = stopCell >= 0 ? localIndex(cluster, stopCell) : -1;
+    localQueue.clear();
+    localQueue.push_back(source);
+    localDistance[source] = 0;
+    localParent[source] = -1;
+    for (size_t head = 0; head < localQueue.size(); ++head) {
+        int index = localQueue[head];
+        if (index == stop) {
+            break; // Cells further out keep whatever distance they were given so far
+        }
+        int x = index % clusterSize;
+        int y = index / clusterSize;
+        int neighbors[4] = {
+            x > 0 ? index - 1 : -1,
+            x < sizeX - 1 ? index + 1 : -1,
+            y > 0 ? index - clusterSize : -1,
+            y < sizeY - 1 ? index + clusterSize : -1
+        };
+        for (int neighbor : neighbors) {
+            if (neighbor >= 0 && localWalkable[neighbor] && localDistance[neighbor] < 0) {
+                localDistance[neighbor] = localDistance[index] + 1;
+                localParent[neighbor] = index;
+                localQueue.push_back(neighbor);
+            }
+        }
+    }
+}
+
+int HierarchicalPathfinder::heuristic(int a, int b) const {
+    return std::abs(a % width - b % width) + std::abs(a / width - b / width);
+}
+
+void HierarchicalPathfinder::touch(int id) {
+    if (stamps.touch(id)) {
+        gCost[id] = std::numeric_limits<int>::max();
+        parent[id] = -1;
+    }
+}
+
+bool HierarchicalPathfinder::findAbstractPath(int startX, int startY, int goalX, int goalY, std::vector<int>& abstractPath) {
+    abstractPath.clear();
+    lastExpandedNodes = 0;
+    if (!grid.isInside(startX, startY) || !grid.isWalkable(goalX, goalY)) {
+        return false;
+    }
+    if (width != grid.getWidth() || height != grid.getHeight()) {
+        resize();
+    }
+
+    int startCell = startY * width + startX;
+    int goalCell = goalY * width + goalX;
+    int startId = static_cast<int>(clusters.size()) * nodesPerCluster;
+    int goalId = startId + 1;
+    int goalClusterIndex = clusterOf(goalX, goalY);
+    const Cluster& goalCluster = builtCluster(goalClusterIndex);
+
+    stamps.advance();
+    open.clear();
+
+    // Ids past the goal stand for cells next to the start that lie in another cluster
+    int borderCells[4];
+    auto cellOf = [&](int id) {
+        if (id == startId) return startCell;
+        if (id == goalId) return goalCell;
+        if (id > goalId) return borderCells[id - goalId - 1];
+        return clusters[id / nodesPerCluster].nodeCells[id % nodesPerCluster];
+    };
+    auto relax = [&](int id, int from, int cost) {
+        touch(id);
+        if (cost < gCost[id]) {
+            gCost[id] = cost;
+            parent[id] = from;
+            int h = heuristic(cellOf(id), goalCell);
+            open.push(id, { cost + h, h });
+        }
+    };
+
+    // Connect the goal to the entrances of its cluster
+    searchCluster(goalCluster, goalCell);
+    goalDistances.clear();
+    for (int cell : goalCluster.nodeCells) {
+        goalDistances.push_back(distanceInCluster(goalCluster, cell));
+    }
+
+    // Connect a cell to the entrances of its cluster, and to the goal if it shares that cluster
+    auto connect = [&](int sourceId, int sourceCell, int baseCost) {
+        int clusterIndex = clusterOf(sourceCell % width, sourceCell / width);
+        const Cluster& cluster = builtCluster(clusterIndex);
+        searchCluster(cluster, sourceCell);
+        for (int i = 0; i < cluster.nodeCount(); ++i) {
+            int distance = distanceInCluster(cluster, cluster.nodeCells[i]);
+            if (distance >= 0) {
+                relax(clusterIndex * nodesPerCluster + i, sourceId, baseCost + distance);
+            }
+        }
+        if (clusterIndex == goalClusterIndex && distanceInCluster(cluster, goalCell) >= 0) {
+            relax(goalId, sourceId, baseCost + distanceInCluster(cluster, goalCell));
+        }
+    };
+
+    touch(startId);
+    gCost[startId] = 0;
+    connect(startId, startCell, 0);
+
+    // The start is usually the snake's head, which is blocked and so never an entrance itself.
+    // Stepping straight over a cluster border from it has to be offered explicitly.
+    int startClusterIndex = clusterOf(startX, startY);
+    for (int k = 0; k < 4; ++k) {
+        int neighborX = startX + neighborOffsets[k][0];
+        int neighborY = startY + neighborOffsets[k][1];
+        borderCells[k] = -1;
+        if (grid.isWalkable(neighborX, neighborY) && clusterOf(neighborX, neighborY) != startClusterIndex) {
+            int id = goalId + 1 + k;
+            borderCells[k] = neighborY * width + neighborX;
+            touch(id);
+            gCost[id] = 1;
+            parent[id] = startId;
+            connect(id, borderCells[k], 1);
+        }
+    }
+
+    while (!open.empty()) {
+        int id = open.pop();
+        lastExpandedNodes++;
+        if (id == goalId) {
+            for (int step = goalId; step != -1; step = parent[step]) {
+                abstractPath.push_back(cellOf(step));
+            }
+            std::reverse(abstractPath.begin(), abstractPath.end());
+            return true;
+        }
+
+        int clusterIndex = id / nodesPerCluster;
+        int local = id % nodesPerCluster;
+        const Cluster& cluster = clusters[clusterIndex];
+        for (int edge = cluster.edgeStart[local]; edge < cluster.edgeStart[local + 1]; ++edge) {
+            relax(clusterIndex * nodesPerCluster + cluster.edges[edge].target, id, gCost[id] + cluster.edges[edge].cost);
+        }
+        for (int slot = 0; slot < maxPartners; ++slot) {
+            int partnerCell = cluster.partnerCells[local * maxPartners + slot];
+            if (partnerCell < 0) {
+                break;
+            }
+            builtCluster(clusterOf(partnerCell % width, partnerCell / width));
+            int partner = findNode(partnerCell);
+            if (partner >= 0) {
+                relax(partner, id, gCost[id] + 1);
+            }
+        }
+        if (clusterIndex == goalClusterIndex && goalDistances[local] >= 0) {
+            relax(goalId, id, gCost[id] + goalDistances[local]);
+        }
+    }
+    return false;
+}
+
+// False (and path untouched) if toCell can't be reached from fromCell without leaving the cluster
+bool HierarchicalPathfinder::appendLocalPath(const Cluster& cluster, int fromCell, int toCell, std::vector<int>& path) {
+    searchCluster(cluster, fromCell, toCell);
+    if (distanceInCluster(cluster, toCell) < 0) {
+        return false;
+    }
+    size_t firstStep = path.size();
+    int source = localIndex(cluster, fromCell);
+    for (int index = localIndex(cluster, toCell); index != source; index = localParent[index]) {
+        path.push_back((cluster.minY + index / clusterSize) * width + cluster.minX + index % clusterSize);
+    }
+    std::reverse(path.begin() + firstStep, path.end());
+    return true;
+}
+
+std::vector<int> HierarchicalPathfinder::findPath(int startX, int startY, int goalX, int goalY) {
+    std::vector<int> path;
+    findPath(startX, startY, goalX, goalY, path);
+    return path;
+}
+
+bool HierarchicalPathfinder::findPath(int startX, int startY, int goalX, int goalY, std::vector<int>& path) {
+    path.clear();
+    routeGoal = -1;
+    if (!findAbstractPath(startX, startY, goalX, goalY, abstractRoute)) {
+        return false;
+    }
+
+    // Refine: crossing an entrance is a single step, anything else stays within one cluster
+    for (size_t i = 1; i < abstractRoute.size(); ++i) {
+        int from = abstractRoute[i - 1];
+        int to = abstractRoute[i];
+        int toCluster = clusterOf(to % width, to / width);
+        if (clusterOf(from % width, from / width) != toCluster) {
+            path.push_back(to);
+        }
+        else if (from != to && !appendLocalPath(clusters[toCluster], from, to, path)) {
+            path.clear();
+            return false;
+        }
+    }
+    routeGoal = goalY * width + goalX;
+    routeNext = 1;
+    return true;
+}
+
+bool HierarchicalPathfinder::findNextLeg(int startX, int startY, int goalX, int goalY, std::vector<int>& path) {
+    path.clear();
+    if (!grid.isInside(startX, startY) || !grid.isWalkable(goalX, goalY)) {
+        return false;
+    }
+    if (startX == goalX && startY == goalY) {
+        return true;
+    }
+
+    int startCell = startY * grid.getWidth() + startX;
+    if (routeGoal == goalY * grid.getWidth() + goalX && width == grid.getWidth() && height == grid.getHeight()
+        && appendNextLeg(startCell, path)) {
+        return true;
+    }
+
+    routeGoal = -1;
+    if (!findAbstractPath(startX, startY, goalX, goalY, abstractRoute)) {
+        return false;
+    }
+    routeGoal = goalY * width + goalX;
+    routeNext = 1;
+    return appendNextLeg(startCell, path);
+}
+
+// Refine the kept route from startCell up to its next waypoint. False if startCell isn't on the way to that
+// waypoint any more (the mover strayed) or the cells between them got blocked.
+bool HierarchicalPathfinder::appendNextLeg(int startCell, std::vector<int>& path) {
+    while (routeNext < abstractRoute.size() && abstractRoute[routeNext] == startCell) {
+        routeNext++; // Waypoint reached
+    }
+    if (routeNext == abstractRoute.size()) {
+        return false;
+    }
+
+    int next = abstractRoute[routeNext];
+    int startX = startCell % width, startY = startCell / width;
+    int nextX = next % width, nextY = next / width;
+    if (std::abs(startX - nextX) + std::abs(startY - nextY) == 1) {
+        if (!grid.isWalkable(nextX, nextY)) {
+            return false;
+        }
+        path.push_back(next); // Crossing into the next cluster
+        return true;
+    }
+    int clusterIndex = clusterOf(nextX, nextY);
+    return clusterOf(startX, startY) == clusterIndex && appendLocalPath(clusters[clusterIndex], startCell, next, path);
+}
@@ -0,0 +1,106 @@
+#ifndef HIERARCHICAL_PATHFINDER_H
+#define HIERARCHICAL_PATHFINDER_H
+
+#include <vector>
+#include <utility>
+#include "Grid.h"
+#include "IndexedHeap.h"
+#include "EpochStamps.h"
+
+// HPA* planner for large boards. The grid is cut into square clusters; walkable openings between
+// neighboring clusters become entrance nodes, and the distances between the entrances of a cluster
+// are precomputed. A query searches this small abstract graph, then refines each abstract edge with
+// a search confined to one cluster. Routes are near-optimal rather than exactly shortest.
+// Clusters are built lazily, when the abstract search first reaches them, so a query pays for the clusters it
+// explores rather than the whole board. A goal that can't be reached still cuts every cluster reachable from
+// the start. Editing a cell marks the cluster(s) that own it to be cut again the same way.
+// A mover that asks again after every step should use findNextLeg: the abstract route is kept and only
+// the edge ahead is refined, so a step costs one search inside one cluster instead of a whole query.
+class HierarchicalPathfinder : public GridListener {
+public:
+    explicit HierarchicalPathfinder(Grid& grid, int clusterSize = 16);
+    ~HierarchicalPathfinder();
+    HierarchicalPathfinder(const HierarchicalPathfinder&) = delete;
+    HierarchicalPathfinder& operator=(const HierarchicalPathfinder&) = delete;
+
+    // Cells from start (excluded) to goal (included), empty if the goal can't be reached
+    std::vector<int> findPath(int startX, int startY, int goalX, int goalY);
+    // Same, into a caller-owned path whose storage is reused. Returns false if the goal can't be reached.
+    bool findPath(int startX, int startY, int goalX, int goalY, std::vector<int>& path);
+    // Cells from start (excluded) to the next waypoint of the kept abstract route. The route is planned when the
+    // goal changes or the start has left it, and re-planned if the leg ahead got blocked; otherwise nothing
+    // outside the start's cluster is looked at. Empty and true when start is the goal.
+    bool findNextLeg(int startX, int startY, int goalX, int goalY, std::vector<int>& path);
+    // Abstract route only: start, the entrances crossed, then goal. False (and empty) if the goal can't be reached.
+    bool findAbstractPath(int startX, int startY, int goalX, int goalY, std::vector<int>& abstractPath);
+    int getLastExpandedNodes() const { return lastExpandedNodes; }
+    int getClusterSize() const { return clusterSize; }
+
+    void onWalkabilityChanged(int x, int y, bool) override;
+    void onGridReset() override;
+
+private:
+    struct Edge {
+        int target; // Local index of another node of the same cluster
+        int cost;
+    };
+
+    // Entrances of a cluster, in flat arrays that keep their capacity across rebuilds, so rebuilding a cluster
+    // whose entrances didn't multiply allocates nothing. Node i sits on nodeCells[i], faces up to maxPartners
+    // entrance cells of neighboring clusters (partnerCells[i * maxPartners ...], -1 past the last), and its edges
+    // are edges[edgeStart[i]] up to edges[edgeStart[i + 1]].
+    static const int maxPartners = 4; // A cell of a one-cell-wide cluster borders four others
+
+    struct Cluster {
+        int minX, minY, maxX, maxY; // Inclusive bounds
+        bool dirty = true; // Entrances and edges are out of date, rebuilt when a search next reaches the cluster
+        std::vector<int> nodeCells;
+        std::vector<int> partnerCells;
+        std::vector<int> edgeStart;
+        std::vector<Edge> edges;
+
+        int nodeCount() const { return static_cast<int>(nodeCells.size()); }
+    };
+
+    Grid& grid;
+    int clusterSize;
+    int width = 0, height = 0;
+    int clustersX = 0, clustersY = 0;
+    int nodesPerCluster = 0; // Upper bound on entrances per cluster, used to give every node a dense id
+    std::vector<Cluster> clusters;
+    int lastExpandedNodes = 0;
+
+    // Abstract search state, stamped per query
+    IndexedHeap<std::pair<int, int>> open;
+    std::vector<int> gCost, parent;
+    EpochStamps stamps;
+    std::vector<int> goalDistances; // From the goal to each entrance of its cluster
+    std::vector<int> abstractRoute; // Last route planned, followed by findNextLeg
+    int routeGoal = -1; // Goal cell of abstractRoute, -1 once it can't be followed any more
+    size_t routeNext = 0; // Index in abstractRoute of the next waypoint to reach
+
+    // Search confined to one cluster, indexed by position inside the cluster
+    std::vector<bool> localWalkable;
+    int loadedCluster = -1; // Cluster currently copied into localWalkable
+    std::vector<int> localDistance, localParent, localQueue;
+
+    void resize();
+    void markDirty(int clusterIndex);
+    const Cluster& builtCluster(int clusterIndex); // Rebuilds the cluster first if it is dirty
+    void rebuildCluster(int clusterIndex);
+    void addTransitions(Cluster& cluster, int fromX, int fromY, int toX, int toY, int stepX, int stepY, int acrossX, int acrossY);
+    void addEntrance(Cluster& cluster, int cell, int partnerCell);
+
+    int clusterOf(int x, int y) const { return (y / clusterSize) * clustersX + (x / clusterSize); }
+    int findNode(int cell) const; // Dense id of the entrance on this cell, -1 if none
+    void loadCluster(const Cluster& cluster);
+    void searchCluster(const Cluster& cluster, int sourceCell, int stopCell = -1); // BFS inside the cluster, until stopCell if given
+    int localIndex(const Cluster& cluster, int cell) const;
+    int distanceInCluster(const Cluster& cluster, int cell) const;
+    bool appendLocalPath(const Cluster& cluster, int fromCell, int toCell, std::vector<int>& path);
+    bool appendNextLeg(int startCell, std::vector<int>& path);
+    int heuristic(int a, int b) const;
+    void touch(int id);
+};
+
+#endif // HIERARCHICAL_PATHFINDER_H
@@ -0,0 +1,213 @@
+#include "IncrementalPlanner.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    const int neighborOffsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+}
+
+IncrementalPlanner::IncrementalPlanner(Grid& grid) : grid(grid) {
+    grid.addListener(this);
+}
+
+IncrementalPlanner::~IncrementalPlanner() {
+    grid.removeListener(this);
+}
+
+void IncrementalPlanner::onGridReset() {
+    // Forget the goal, so the next query starts a new search tree
+    goal = -1;
+    changedCells.clear();
+}
+
+void IncrementalPlanner::onWalkabilityChanged(int x, int y, bool) {
+    // Repairs are done lazily at the next query, so a burst of edits is only paid for once
+    if (goal < 0) {
+        return;
+    }
+    if (static_cast<int>(changedCells.size()) >= width * height) {
+        goal = -1;
+        changedCells.clear();
+        return;
+    }
+    changedCells.push_back(y * width + x);
+}
+
+void IncrementalPlanner::initialize(int goalCell) {
+    if (width != grid.getWidth() || height != grid.getHeight()) {
+        width = grid.getWidth();
+        height = grid.getHeight();
+        g.assign(width * height, infinity());
+        rhs.assign(width * height, infinity());
+        stamps.resize(width * height);
+    }
+
+    // A new epoch makes every cell's g and rhs infinite again without touching them
+    stamps.advance();
+
+    open.clear();
+    open.reserve(width * height);
+    changedCells.clear();
+    keyModifier = 0;
+    goal = goalCell;
+
+    touch(goal);
+    rhs[goal] = 0;
+    open.push(goal, calculateKey(goal));
+}
+
+void IncrementalPlanner::touch(int cell) {
+    if (stamps.touch(cell)) {
+        g[cell] = infinity();
+        rhs[cell] = infinity();
+    }
+}
+
+int IncrementalPlanner::heuristic(int a, int b) const {
+    return std::abs(a % width - b % width) + std::abs(a / width - b / width);
+}
+
+IncrementalPlanner::Key IncrementalPlanner::calculateKey(int cell) const {
+    int cost = std::min(getG(cell), getRhs(cell));
+    return Key(cost + heuristic(start, cell) + keyModifier, cost);
+}
+
+int IncrementalPlanner::bestSuccessorCost(int cell) const {
+    int x = cell % width;
+    int y = cell / width;
+    int best = infinity();
+    for (auto& offset : neighborOffsets) {
+        int neighborX = x + offset[0];
+        int neighborY = y + offset[1];
+        // Moving onto a cell costs 1, or is impossible if that cell is blocked
+        if (grid.isWalkable(neighborX, neighborY)) {
+            best = std::min(best, 1 + getG(neighborY * width + neighborX));
+        }
+    }
+    return best;
+}
+
+void IncrementalPlanner::updateVertex(int cell) {
+    touch(cell);
+    if (cell != goal) {
+        rhs[cell] = bestSuccessorCost(cell);
+    }
+
+    if (g[cell] != rhs[cell]) {
+        open.push(cell, calculateKey(cell));
+    }
+    else {
+        open.remove(cell);
+    }
+}
+
+void IncrementalPlanner::computeShortestPath() {
+    while (!open.empty() && (open.topKey() < calculateKey(start) || getRhs(start) != getG(start))) {
+        int cell = open.top();
+        Key oldKey = open.topKey();
+        Key newKey = calculateKey(cell);
+        lastExpandedNodes++;
+
+        if (oldKey < newKey) {
+            // The key was computed before the start moved: requeue it with the current heuristic
+            open.push(cell, newKey);
+            continue;
+        }
+
+        open.pop();
+        bool overConsistent = g[cell] > rhs[cell];
+        if (overConsistent) {
+            g[cell] = rhs[cell];
+        }
+        else {
+            g[cell] = infinity();
+            updateVertex(cell);
+        }
+
+        int x = cell % width;
+        int y = cell / width;
+        for (auto& offset : neighborOffsets) {
+            int neighborX = x + offset[0];
+            int neighborY = y + offset[1];
+            if (neighborX >= 0 && neighborX < width && neighborY >= 0 && neighborY < height) {
+                updateVertex(neighborY * width + neighborX);
+            }
+        }
+    }
+}
+
+std::vector<int> IncrementalPlanner::findPath(int startX, int startY, int goalX, int goalY) {
+    std::vector<int> path;
+    findPath(startX, startY, goalX, goalY, path);
+    return path;
+}
+
+bool IncrementalPlanner::findPath(int startX, int startY, int goalX, int goalY, std::vector<int>& path) {
+    path.clear();
+    lastExpandedNodes = 0;
+    if (!grid.isInside(startX, startY) || !grid.isInside(goalX, goalY)) {
+        return false;
+    }
+
+    int goalCell = goalY * grid.getWidth() + goalX;
+    if (goal != goalCell || width != grid.getWidth() || height != grid.getHeight()) {
+        start = startY * grid.getWidth() + startX;
+        lastStart = start;
+        initialize(goalCell);
+    }
+    else {
+        start = startY * width + startX;
+    }
+
+    if (start != lastStart && lastStart >= 0) {
+        keyModifier += heuristic(lastStart, start);
+    }
+    lastStart = start;
+
+    // A cell that flipped walkability changes the cost of every edge leading into it
+    for (int cell : changedCells) {
+        int x = cell % width;
+        int y = cell / width;
+        for (auto& offset : neighborOffsets) {
+            int neighborX = x + offset[0];
+            int neighborY = y + offset[1];
+            if (neighborX >= 0 && neighborX < width && neighborY >= 0 && neighborY < height) {
+                updateVertex(neighborY * width + neighborX);
+            }
+        }
+    }
+    changedCells.clear();
+
+    computeShortestPath();
+
+    if (getG(start) >= infinity()) {
+        return false;
+    }
+
+    // Walk down the cost-to-goal gradient
+    int cell = start;
+    while (cell != goal && static_cast<int>(path.size()) < width * height) {
+        int x = cell % width;
+        int y = cell / width;
+        int next = -1;
+        int nextCost = infinity();
+        for (auto& offset : neighborOffsets) {
+            int neighborX = x + offset[0];
+            int neighborY = y + offset[1];
+            if (grid.isWalkable(neighborX, neighborY)) {
+                int neighbor = neighborY * width + neighborX;
+                if (getG(neighbor) < nextCost) {
+                    nextCost = getG(neighbor);
+                    next = neighbor;
+                }
+            }
+        }
+        if (next < 0) {
+            path.clear();
+            return false;
+        }
+        cell = next;
+        path.push_back(cell);
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef INCREMENTAL_PLANNER_H
+#define INCREMENTAL_PLANNER_H
+
+#include <vector>
+#include <utility>
+#include "Grid.h"
+#include "IndexedHeap.h"
+#include "EpochStamps.h"
+
+// D* Lite planner. The search runs backwards from the goal and its tree is kept between calls:
+// when cells change walkability or the start moves, only the part of the tree they affect is repaired.
+// The tree is rebuilt from scratch only when the goal moves.
+class IncrementalPlanner : public GridListener {
+public:
+    explicit IncrementalPlanner(Grid& grid);
+    ~IncrementalPlanner();
+    IncrementalPlanner(const IncrementalPlanner&) = delete;
+    IncrementalPlanner& operator=(const IncrementalPlanner&) = delete;
+
+    // Cells from start (excluded) to goal (included), empty if the goal can't be reached
+    std::vector<int> findPath(int startX, int startY, int goalX, int goalY);
+    // Same, into a caller-owned path whose storage is reused. Returns false if the goal can't be reached.
+    bool findPath(int startX, int startY, int goalX, int goalY, std::vector<int>& path);
+    int getLastExpandedNodes() const { return lastExpandedNodes; }
+
+    void onWalkabilityChanged(int x, int y, bool) override;
+    void onGridReset() override;
+
+private:
+    typedef std::pair<int, int> Key;
+
+    Grid& grid;
+    int width = 0, height = 0;
+    std::vector<int> g, rhs; // Cost-to-goal estimates, only valid where stamped for the current goal
+    EpochStamps stamps;
+    IndexedHeap<Key> open;
+    // Cells whose walkability flipped since the last findPath. At most one entry per cell, like Grid's journal:
+    // past that, repairing costs more than a new search, so the tree is dropped and the next query starts over.
+    std::vector<int> changedCells;
+
+    int start = -1, goal = -1, lastStart = -1;
+    int keyModifier = 0; // km in the D* Lite paper: heuristic drift accumulated as the start moves
+    int lastExpandedNodes = 0;
+
+    void initialize(int goalCell);
+    int getG(int cell) const { return stamps.isCurrent(cell) ? g[cell] : infinity(); }
+    int getRhs(int cell) const { return stamps.isCurrent(cell) ? rhs[cell] : infinity(); }
+    void touch(int cell);
+    int heuristic(int a, int b) const;
+    Key calculateKey(int cell) const;
+    void updateVertex(int cell);
+    void computeShortestPath();
+    int bestSuccessorCost(int cell) const; // min over neighbors of step cost + g
+    static int infinity() { return std::numeric_limits<int>::max() / 2; }
+};
+
+#endif // INCREMENTAL_PLANNER_H
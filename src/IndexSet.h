@@ -0,0 +1,84 @@
+#ifndef INDEX_SET_H
+#define INDEX_SET_H
+
+#include <vector>
+#include <cstddef>
+
+// Set of integer ids in [0, capacity): a dense list of the members plus each id's slot in that list.
+// Insert, erase and membership are O(1) (erase swaps the last member into the hole), and the members
+// can be walked or picked from at random like a plain array. Member order is arbitrary.
+class IndexSet {
+public:
+    // Empty set over ids [0, capacity)
+    void reset(int capacity) {
+        members.clear();
+        slot.assign(capacity, -1);
+    }
+
+    // Empty set with the same capacity; costs O(size()), not O(capacity)
+    void clear() {
+        for (int id : members) {
+            slot[id] = -1;
+        }
+        members.clear();
+    }
+
+    // Every id in [0, capacity) is a member
+    void fill(int capacity) {
+        members.resize(capacity);
+        slot.resize(capacity);
+        for (int id = 0; id < capacity; ++id) {
+            members[id] = id;
+            slot[id] = id;
+        }
+    }
+
+    // Exactly the ids in [0, capacity) for which isMember(id) is true, in one branch-free pass
+    template <typename IsMember>
+    void fill(int capacity, IsMember isMember) {
+        members.resize(capacity);
+        slot.resize(capacity);
+        int count = 0;
+        for (int id = 0; id < capacity; ++id) {
+            bool member = isMember(id);
+            members[count] = id; // Overwritten by the next id unless this one is kept
+            slot[id] = member ? count : -1;
+            count += member;
+        }
+        members.resize(count);
+    }
+
+    bool contains(int id) const { return slot[id] >= 0; }
+    int size() const { return static_cast<int>(members.size()); }
+    bool empty() const { return members.empty(); }
+    int operator[](int index) const { return members[index]; }
+    const std::vector<int>& getMembers() const { return members; }
+    size_t getMemoryBytes() const { return (members.capacity() + slot.capacity()) * sizeof(int); }
+    std::vector<int>::const_iterator begin() const { return members.begin(); }
+    std::vector<int>::const_iterator end() const { return members.end(); }
+
+    void insert(int id) {
+        if (slot[id] < 0) {
+            slot[id] = static_cast<int>(members.size());
+            members.push_back(id);
+        }
+    }
+
+    void erase(int id) {
+        int hole = slot[id];
+        if (hole < 0) {
+            return;
+        }
+        int last = members.back();
+        members[hole] = last;
+        slot[last] = hole;
+        members.pop_back();
+        slot[id] = -1;
+    }
+
+private:
+    std::vector<int> members;
+    std::vector<int> slot; // Position of each id in members, -1 if it isn't a member
+};
+
+#endif // INDEX_SET_H
@@ -0,0 +1,119 @@
+#ifndef INDEXED_HEAP_H
+#define INDEXED_HEAP_H
+
+#include <vector>
+#include <cstddef>
+
+// Binary min-heap of integer ids (0 .. capacity-1) with O(1) membership test and decrease-key.
+// Every id remembers its slot in the heap, so updating or removing an entry never has to search for it.
+template <typename Key>
+class IndexedHeap {
+public:
+    // Make room for ids in [0, capacity). Existing entries are kept. The heap itself is not sized for every id:
+    // it grows with the queue and keeps its capacity across clear(), so it settles at the largest queue seen.
+    void reserve(int capacity) {
+        if (static_cast<int>(position.size()) < capacity) {
+            position.resize(capacity, -1);
+        }
+    }
+
+    bool empty() const { return entries.empty(); }
+    int size() const { return static_cast<int>(entries.size()); }
+    size_t getMemoryBytes() const { return entries.capacity() * sizeof(Entry) + position.capacity() * sizeof(int); }
+    bool contains(int id) const { return id >= 0 && id < static_cast<int>(position.size()) && position[id] >= 0; }
+
+    int top() const { return entries.front().id; }
+    const Key& topKey() const { return entries.front().key; }
+    const Key& keyOf(int id) const { return entries[position[id]].key; }
+
+    // Insert a new id, or change the key of an id that is already queued (up or down)
+    void push(int id, const Key& key) {
+        if (contains(id)) {
+            int slot = position[id];
+            bool decreased = key < entries[slot].key;
+            entries[slot].key = key;
+            if (decreased) siftUp(slot);
+            else siftDown(slot);
+            return;
+        }
+        reserve(id + 1);
+        entries.push_back(Entry{ key, id });
+        position[id] = static_cast<int>(entries.size()) - 1;
+        siftUp(position[id]);
+    }
+
+    // Remove and return the id with the smallest key
+    int pop() {
+        int id = entries.front().id;
+        removeAt(0);
+        return id;
+    }
+
+    void remove(int id) {
+        if (contains(id)) {
+            removeAt(position[id]);
+        }
+    }
+
+    // Only the ids still queued are touched, so this costs O(size()), not O(capacity)
+    void clear() {
+        for (const Entry& entry : entries) {
+            position[entry.id] = -1;
+        }
+        entries.clear();
+    }
+
+private:
+    struct Entry {
+        Key key;
+        int id;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<int> position; // Slot of each id in entries, -1 when not queued
+
+    void removeAt(int slot) {
+        position[entries[slot].id] = -1;
+        int last = static_cast<int>(entries.size()) - 1;
+        if (slot != last) {
+            entries[slot] = entries[last];
+            position[entries[slot].id] = slot;
+        }
+        entries.pop_back();
+        if (slot < last) {
+            siftDown(slot);
+            siftUp(slot);
+        }
+    }
+
+    void siftUp(int slot) {
+        Entry entry = entries[slot];
+        while (slot > 0) {
+            int parent = (slot - 1) / 2;
+            if (!(entry.key < entries[parent].key)) break;
+            entries[slot] = entries[parent];
+            position[entries[slot].id] = slot;
+            slot = parent;
+        }
+        entries[slot] = entry;
+        position[entry.id] = slot;
+    }
+
+    void siftDown(int slot) {
+        Entry entry = entries[slot];
+        int count = static_cast<int>(entries.size());
+        while (true) {
+            int child = slot * 2 + 1;
+            if (child >= count) break;
+            if (child + 1 < count && entries[child + 1].key < entries[child].key) child++;
+            if (!(entries[child].key < entry.key)) break;
+            entries[slot] = entries[child];
+            position[entries[slot].id] = slot;
+            slot = child;
+        }
+        entries[slot] = entry;
+        position[entry.id] = slot;
+    }
+};
+
+#endif // INDEXED_HEAP_H
@@ -0,0 +1,160 @@
+#include "LevelFile.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const uint32_t levelVersion = 1;
+}
+
+LevelFile::~LevelFile() {
+    close();
+}
+
+bool LevelFile::open(const std::string& path) {
+    close();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(file, &status) == 0 && status.st_size > 0) {
+        void* mapped = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapped != MAP_FAILED) {
+            data = mapped;
+            size = static_cast<size_t>(status.st_size);
+        }
+    }
+    ::close(file); // The mapping stays valid on its own
+#endif
+    if (data == nullptr) {
+        close();
+        return false;
+    }
+
+    // Check the header and that the file is long enough for everything it announces
+    header = static_cast<const Header*>(data);
+    bool valid = size >= sizeof(Header) && std::memcmp(header->magic, "SNKL", 4) == 0 && header->version == levelVersion &&
+                 header->width > 0 && header->height > 0;
+    if (valid) {
+        size_t pillOffset = sizeof(Header) + obstacleWords(header->width, header->height) * sizeof(uint64_t);
+        valid = size >= pillOffset + static_cast<size_t>(header->pillCount) * 2 * sizeof(int32_t);
+        if (valid) {
+            obstacleBits = reinterpret_cast<const uint64_t*>(static_cast<const char*>(data) + sizeof(Header));
+            pills = reinterpret_cast<const int32_t*>(static_cast<const char*>(data) + pillOffset);
+        }
+    }
+
+    // Then that what the header places fits on its board
+    if (valid && !isFreeCell(header->snakeX, header->snakeY)) {
+        std::cerr << "Level snake start " << header->snakeX << ", " << header->snakeY << " is off the board or on an obstacle" << std::endl;
+        valid = false;
+    }
+    for (uint32_t i = 0; valid && i < header->pillCount; ++i) {
+        if (!isFreeCell(pills[2 * i], pills[2 * i + 1])) {
+            std::cerr << "Level pill " << pills[2 * i] << ", " << pills[2 * i + 1] << " is off the board or on an obstacle" << std::endl;
+            valid = false;
+        }
+    }
+    if (!valid) {
+        close();
+    }
+    return valid;
+}
+
+bool LevelFile::isFreeCell(int x, int y) const {
+    if (x < 0 || x >= header->width || y < 0 || y >= header->height) {
+        return false;
+    }
+    size_t cell = static_cast<size_t>(y) * header->width + x;
+    return ((obstacleBits[cell >> 6] >> (cell & 63)) & 1) == 0;
+}
+
+void LevelFile::close() {
+#if defined(_WIN32)
+    if (data != nullptr) UnmapViewOfFile(data);
+    if (mappingHandle != nullptr) CloseHandle(mappingHandle);
+    if (fileHandle != nullptr) CloseHandle(fileHandle);
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    if (data != nullptr) munmap(const_cast<void*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+    header = nullptr;
+    obstacleBits = nullptr;
+    pills = nullptr;
+}
+
+bool LevelFile::applyTo(Grid& grid) const {
+    if (header == nullptr || grid.getWidth() != header->width || grid.getHeight() != header->height) {
+        return false;
+    }
+
+    // The obstacle layer goes in straight from the mapping, in one pass; only the pills are placed one by one
+    grid.loadObstacles(obstacleBits);
+    for (uint32_t i = 0; i < header->pillCount; ++i) {
+        grid.setCellContent(pills[2 * i], pills[2 * i + 1], CellContent::Pill);
+    }
+    return true;
+}
+
+bool LevelFile::save(const std::string& path, const Grid& grid, int snakeX, int snakeY) {
+    Header fileHeader = {};
+    std::memcpy(fileHeader.magic, "SNKL", 4);
+    fileHeader.version = levelVersion;
+    fileHeader.width = grid.getWidth();
+    fileHeader.height = grid.getHeight();
+    fileHeader.snakeX = snakeX;
+    fileHeader.snakeY = snakeY;
+
+    std::vector<uint64_t> obstacles(obstacleWords(grid.getWidth(), grid.getHeight()), 0);
+    grid.forEachCell(CellContent::Obstacle, [&](int x, int y) {
+        int cell = y * grid.getWidth() + x;
+        obstacles[cell >> 6] |= uint64_t(1) << (cell & 63);
+    });
+    std::vector<int32_t> pillCells;
+    grid.forEachCell(CellContent::Pill, [&](int x, int y) {
+        pillCells.push_back(x);
+        pillCells.push_back(y);
+    });
+    fileHeader.pillCount = static_cast<uint32_t>(pillCells.size() / 2);
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+    file.write(reinterpret_cast<const char*>(obstacles.data()), obstacles.size() * sizeof(uint64_t));
+    file.write(reinterpret_cast<const char*>(pillCells.data()), pillCells.size() * sizeof(int32_t));
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,62 @@
+#ifndef LEVEL_FILE_H
+#define LEVEL_FILE_H
+
+#include <string>
+#include <cstdint>
+#include "Grid.h"
+
+// Binary level format, read through a memory mapping so nothing is parsed or copied up front:
+//   32-byte header  "SNKL", version, width, height, snake start x/y, pill count, reserved (little-endian)
+//   obstacle layer  one bit per cell, row-major, in 64-bit words: the same layout as a CellPlanes plane
+//   pill list       pill count (x, y) pairs of int32
+// The header keeps the obstacle words 8-byte aligned, so getObstacleBits points straight into the file.
+class LevelFile {
+public:
+    LevelFile() = default;
+    ~LevelFile();
+    LevelFile(const LevelFile&) = delete;
+    LevelFile& operator=(const LevelFile&) = delete;
+
+    // Maps the file and checks it; false if it isn't a valid level. Besides the header and the length, the snake
+    // start and every pill must lie on the level's board and off its obstacles.
+    bool open(const std::string& path);
+    void close();
+
+    int getWidth() const { return header ? header->width : 0; }
+    int getHeight() const { return header ? header->height : 0; }
+    int getSnakeX() const { return header ? header->snakeX : 0; }
+    int getSnakeY() const { return header ? header->snakeY : 0; }
+    int getPillCount() const { return header ? static_cast<int>(header->pillCount) : 0; }
+    const uint64_t* getObstacleBits() const { return obstacleBits; }
+    const int32_t* getPills() const { return pills; } // x, y, x, y, ...
+
+    // Replaces the contents of a grid of the level's size with the level's obstacles and pills
+    bool applyTo(Grid& grid) const;
+
+    static bool save(const std::string& path, const Grid& grid, int snakeX, int snakeY);
+
+private:
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        int32_t width, height;
+        int32_t snakeX, snakeY;
+        uint32_t pillCount;
+        uint32_t reserved;
+    };
+
+    const void* data = nullptr;
+    size_t size = 0;
+    const Header* header = nullptr;
+    const uint64_t* obstacleBits = nullptr;
+    const int32_t* pills = nullptr;
+#if defined(_WIN32)
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+
+    static size_t obstacleWords(int width, int height) { return (static_cast<size_t>(width) * height + 63) / 64; }
+    bool isFreeCell(int x, int y) const; // On the board and not an obstacle, by the mapped header and layer
+};
+
+#endif // LEVEL_FILE_H
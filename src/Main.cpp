@@ -1,9 +1,99 @@
 #include "Game.h"
+#include "SelfTest.h"
+#include "Bench.h"
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
 
-int main() {
-    Game game;
+// Usage: Snake3DOpenGL [--headless [ticks]] [--strategy astar|jps|incremental|hierarchical|flowfield|wavefront] [--cluster-size N] [--voxel N] [--world] [--level FILE] [--layout bytes|planes] [--seed N] [--selftest] [--bench]
+// --headless runs the snake without a window or GL context and prints the ticks per second reached.
+// --cluster-size sets the cluster side used by the hierarchical strategy (default 16).
+// --voxel plays in an N^3 arena (N up to 1024) instead of the board, moving in all three dimensions.
+// --world plays on an unbounded plane, stored in chunks allocated only where something was written.
+// --level plays on the board saved in FILE (LevelFile format), starting the snake where the file says.
+// --layout stores the board one byte per cell (the default) or as bit planes, three bits per cell.
+// --seed fixes the board, so a run can be repeated exactly; by default every run gets a new one.
+// --selftest checks that path queries do no heap allocation once warm, and exits nonzero if one does.
+// --bench prints timing tables for the pathfinders and the board, then exits.
+int main(int argc, char* argv[]) {
+    bool headless = false;
+    long long ticks = 1000000;
+    PathStrategy strategy = PathStrategy::AStar;
+    uint64_t seed = static_cast<uint64_t>(time(nullptr));
+    int clusterSize = 16;
+    int voxelSize = 0;
+    bool openWorld = false;
+    const char* levelPath = nullptr;
+    CellLayout layout = CellLayout::Bytes;
 
-    game.run();
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--selftest") == 0) {
+            return runSelfTest() ? 0 : 1;
+        }
+        else if (std::strcmp(argv[i], "--bench") == 0) {
+            runBenchmarks();
+            return 0;
+        }
+        else if (std::strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                ticks = std::atoll(argv[++i]);
+            }
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--cluster-size") == 0 && i + 1 < argc) {
+            clusterSize = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--voxel") == 0 && i + 1 < argc) {
+            voxelSize = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--world") == 0) {
+            openWorld = true;
+        }
+        else if (std::strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+            levelPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--layout") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (std::strcmp(name, "bytes") == 0) layout = CellLayout::Bytes;
+            else if (std::strcmp(name, "planes") == 0) layout = CellLayout::BitPlanes;
+            else {
+                std::cerr << "Unknown layout " << name << "\n";
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--strategy") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (std::strcmp(name, "astar") == 0) strategy = PathStrategy::AStar;
+            else if (std::strcmp(name, "jps") == 0) strategy = PathStrategy::JumpPoint;
+            else if (std::strcmp(name, "incremental") == 0) strategy = PathStrategy::Incremental;
+            else if (std::strcmp(name, "hierarchical") == 0) strategy = PathStrategy::Hierarchical;
+            else if (std::strcmp(name, "flowfield") == 0) strategy = PathStrategy::FlowField;
+            else if (std::strcmp(name, "wavefront") == 0) strategy = PathStrategy::Wavefront;
+            else {
+                std::cerr << "Unknown strategy " << name << "\n";
+                return 1;
+            }
+        }
+    }
+
+    Game game(headless, seed, voxelSize, openWorld);
+    game.setCellLayout(layout);
+    if (levelPath != nullptr && !game.loadLevel(levelPath)) {
+        return 1;
+    }
+    game.setPathStrategy(strategy);
+    game.setClusterSize(clusterSize);
+
+    if (headless) {
+        game.runHeadless(ticks);
+    }
+    else {
+        game.run();
+    }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,85 @@
+#include "PillRegistry.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+void PillRegistry::resize(int width, int height) {
+    this->width = width;
+    this->height = height;
+    bucketsX = (width + bucketSize - 1) / bucketSize;
+    bucketsY = (height + bucketSize - 1) / bucketSize;
+    pills.reset(width * height);
+    buckets.assign(bucketsX * bucketsY, std::vector<int>());
+}
+
+void PillRegistry::clear() {
+    for (int cell : pills) {
+        buckets[bucketOf(cell)].clear();
+    }
+    pills.clear();
+}
+
+void PillRegistry::add(int cell) {
+    if (pills.contains(cell)) {
+        return;
+    }
+    pills.insert(cell);
+    buckets[bucketOf(cell)].push_back(cell);
+}
+
+void PillRegistry::remove(int cell) {
+    if (!pills.contains(cell)) {
+        return;
+    }
+    pills.erase(cell);
+
+    std::vector<int>& bucket = buckets[bucketOf(cell)];
+    bucket.erase(std::find(bucket.begin(), bucket.end(), cell));
+}
+
+// Visit the buckets in square rings around the one holding (x, y). Every cell of ring r + 1 is more than
+// r * bucketSize steps away along some axis, so once the best pill is at most that far the search can stop.
+int PillRegistry::findNearest(int x, int y) const {
+    if (pills.empty()) {
+        return -1;
+    }
+
+    int centerX = x / bucketSize;
+    int centerY = y / bucketSize;
+    int maxRing = std::max(std::max(centerX, bucketsX - 1 - centerX), std::max(centerY, bucketsY - 1 - centerY));
+    int best = -1;
+    int bestDistance = std::numeric_limits<int>::max();
+
+    for (int ring = 0; ring <= maxRing; ++ring) {
+        for (int bucketY = centerY - ring; bucketY <= centerY + ring; ++bucketY) {
+            if (bucketY < 0 || bucketY >= bucketsY) continue;
+
+            // Inner rows of the ring only have their two end buckets
+            bool edgeRow = (bucketY == centerY - ring || bucketY == centerY + ring);
+            int step = edgeRow ? 1 : std::max(2 * ring, 1);
+            for (int bucketX = centerX - ring; bucketX <= centerX + ring; bucketX += step) {
+                if (bucketX < 0 || bucketX >= bucketsX) continue;
+
+                for (int cell : buckets[bucketY * bucketsX + bucketX]) {
+                    int distance = std::abs(cell % width - x) + std::abs(cell / width - y);
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        best = cell;
+                    }
+                }
+            }
+        }
+        if (best >= 0 && bestDistance <= ring * bucketSize) {
+            break;
+        }
+    }
+    return best;
+}
+
+size_t PillRegistry::getMemoryBytes() const {
+    size_t bytes = pills.getMemoryBytes() + buckets.capacity() * sizeof(std::vector<int>);
+    for (const std::vector<int>& bucket : buckets) {
+        bytes += bucket.capacity() * sizeof(int);
+    }
+    return bytes;
+}
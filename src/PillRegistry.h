@@ -0,0 +1,35 @@
+#ifndef PILL_REGISTRY_H
+#define PILL_REGISTRY_H
+
+#include <vector>
+#include <cstddef>
+#include "IndexSet.h"
+
+// Where the pills are, kept up to date by Grid::setCellContent instead of being found by scanning the board.
+// Pills are also filed into coarse square buckets, so the nearest one can be found by looking at the
+// buckets around a cell, closest first, rather than at every pill.
+class PillRegistry {
+public:
+    void resize(int width, int height); // Forgets every pill
+    void clear(); // Same, keeping the size; only costs as much as there are pills
+
+    void add(int cell);
+    void remove(int cell);
+    int size() const { return pills.size(); }
+    const std::vector<int>& getCells() const { return pills.getMembers(); } // Row-major cell indices, in no particular order
+
+    // Pill closest to (x, y) by Manhattan distance; returns -1 if there are none
+    int findNearest(int x, int y) const;
+    size_t getMemoryBytes() const; // The pill set and the bucket lists
+
+private:
+    static const int bucketSize = 8;
+    int width = 0, height = 0;
+    int bucketsX = 0, bucketsY = 0;
+    IndexSet pills;
+    std::vector<std::vector<int>> buckets;
+
+    int bucketOf(int cell) const { return (cell / width / bucketSize) * bucketsX + (cell % width) / bucketSize; }
+};
+
+#endif // PILL_REGISTRY_H
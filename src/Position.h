@@ -0,0 +1,10 @@
+#pragma once
+#include "glm.hpp"
+
+struct Position {
+    Position(float x, float z) : x(x), z(z) {}
+    Position() : x(0), z(0) {}
+    float x, z;
+    float y = 0.5; // Default y position for the snake
+    glm::vec3 toVec3() { return glm::vec3(x, y, z); }
+};
@@ -0,0 +1,59 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// Stream ids of the generators a game owns. Generators given the same seed but different streams still
+// draw unrelated sequences, so a game can seed all of them from its one seed.
+namespace RandomStream {
+    const uint64_t Pills = 0; // The grid's pill placement
+    const uint64_t VoxelObstacles = 1;
+    const uint64_t VoxelPills = 2;
+    const uint64_t WorldPills = 3; // The open world's pills and obstacles
+}
+
+// PCG32 (O'Neill): 64-bit state, 32-bit output, small and fast. The state comes from the seed and the
+// increment from the stream id, so (seed, stream) pairs replay exactly and distinct streams never overlap.
+// Every grid (every simulation) owns one, so independent games never share generator state.
+class Random {
+public:
+    explicit Random(uint64_t seed = 0, uint64_t stream = RandomStream::Pills) { reseed(seed, stream); }
+
+    void reseed(uint64_t seed, uint64_t stream) {
+        increment = (stream << 1) | 1; // Must be odd
+        state = 0;
+        next();
+        state += seed;
+        next();
+    }
+    void reseed(uint64_t seed) { reseed(seed, increment >> 1); } // Keeps the stream
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + increment;
+        uint32_t shifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+        uint32_t rotation = static_cast<uint32_t>(old >> 59);
+        return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+    }
+
+    // Uniform in [0, bound) without modulo bias (Lemire's multiply-and-reject); bound must be > 0.
+    // The rejection branch is only taken for a tiny fraction of draws.
+    uint32_t below(uint32_t bound) {
+        uint64_t product = static_cast<uint64_t>(next()) * bound;
+        uint32_t low = static_cast<uint32_t>(product);
+        if (low < bound) {
+            uint32_t threshold = (0u - bound) % bound;
+            while (low < threshold) {
+                product = static_cast<uint64_t>(next()) * bound;
+                low = static_cast<uint32_t>(product);
+            }
+        }
+        return static_cast<uint32_t>(product >> 32);
+    }
+
+private:
+    uint64_t state;
+    uint64_t increment;
+};
+
+#endif // RANDOM_H
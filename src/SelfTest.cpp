@@ -0,0 +1,232 @@
+#include "SelfTest.h"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <iostream>
+#include "Grid.h"
+#include "IncrementalPlanner.h"
+#include "HierarchicalPathfinder.h"
+#include "FlowField.h"
+#include "BitWavefront.h"
+#include "GridSnapshot.h"
+#include "Random.h"
+
+namespace {
+    unsigned long long allocationCount = 0; // Calls to operator new so far, in the whole program
+
+    struct Query {
+        int startX, startY, goalX, goalY;
+        int editX, editY; // Cell next to the start that flips before the query, as the snake's moves do; -1 if none
+    };
+
+    void toggleEdit(Grid& grid, const Query& query) {
+        if (query.editX < 0) {
+            return;
+        }
+        bool blocked = grid.getCellContent(query.editX, query.editY) == CellContent::Obstacle;
+        grid.setCellContent(query.editX, query.editY, blocked ? CellContent::Empty : CellContent::Obstacle);
+    }
+
+    // Answer every query twice to warm the planner's buffers up, then again while counting allocations.
+    // Every edit cell has flipped an even number of times when counting starts, so each round sees the same board.
+    template <typename Answer>
+    bool checkAllocations(Grid& grid, const char* name, const std::vector<Query>& queries, Answer answer) {
+        for (int round = 0; round < 2; ++round) {
+            for (const Query& query : queries) {
+                toggleEdit(grid, query);
+                answer(query);
+            }
+        }
+
+        int found = 0;
+        unsigned long long before = allocationCount;
+        for (const Query& query : queries) {
+            toggleEdit(grid, query);
+            found += answer(query) ? 1 : 0;
+        }
+        unsigned long long allocations = allocationCount - before;
+        for (const Query& query : queries) {
+            toggleEdit(grid, query); // Back to the board the next planner expects
+        }
+
+        std::cout << "  " << name << ": " << allocations << " allocations over " << queries.size()
+                  << " queries (" << found << " paths found)" << std::endl;
+        return allocations == 0;
+    }
+
+    // A rollout writes snake cells into a fork of the grid and a branch forks the rollout. Writes must stay where
+    // they were made: the grid keeps its contents and version, the rollout doesn't see the branch's writes,
+    // the branch sees the rollout's, and revert() brings the parent's view back.
+    bool checkSnapshots(const Grid& grid, Random& random) {
+        bool passed = true;
+        auto expect = [&](bool condition, const char* what) {
+            if (!condition) {
+                std::cout << "  Snapshot: " << what << std::endl;
+                passed = false;
+            }
+        };
+        int width = grid.getWidth();
+        int height = grid.getHeight();
+        unsigned int version = grid.getVersion();
+
+        GridSnapshot rollout(grid);
+        std::vector<int> written;
+        std::vector<CellContent> original;
+        for (int i = 0; i < 200; ++i) {
+            int x = static_cast<int>(random.below(width));
+            int y = static_cast<int>(random.below(height));
+            written.push_back(y * width + x);
+            original.push_back(grid.getCellContent(x, y));
+            rollout.setCellContent(x, y, CellContent::Snake);
+        }
+        int untouchedX = -1, untouchedY = -1;
+        for (int y = 0; y < height && untouchedX < 0; y += GridSnapshot::chunkSize) {
+            for (int x = 0; x < width && untouchedX < 0; x += GridSnapshot::chunkSize) {
+                if (std::find(written.begin(), written.end(), y * width + x) == written.end()) {
+                    untouchedX = x;
+                    untouchedY = y;
+                }
+            }
+        }
+
+        bool rolloutSeesWrites = true, gridUnchanged = true;
+        for (size_t i = 0; i < written.size(); ++i) {
+            int x = written[i] % width, y = written[i] / width;
+            rolloutSeesWrites &= rollout.getCellContent(x, y) == CellContent::Snake && !rollout.isWalkable(x, y);
+            gridUnchanged &= grid.getCellContent(x, y) == original[i];
+        }
+        expect(rolloutSeesWrites, "a fork lost one of its own writes");
+        expect(gridUnchanged && grid.getVersion() == version, "writing to a fork changed the grid");
+        expect(untouchedX < 0 || rollout.getCellContent(untouchedX, untouchedY) == grid.getCellContent(untouchedX, untouchedY),
+               "an unwritten cell reads differently through the fork");
+        expect(rollout.getCopiedChunkCount() <= static_cast<int>(written.size()), "a fork copied more chunks than it wrote to");
+
+        GridSnapshot branch(&rollout);
+        int firstX = written[0] % width, firstY = written[0] / width;
+        int lastX = written.back() % width, lastY = written.back() / width;
+        branch.setCellContent(firstX, firstY, CellContent::Pill);
+        expect(branch.getCellContent(firstX, firstY) == CellContent::Pill, "a nested fork lost its write");
+        expect(rollout.getCellContent(firstX, firstY) == CellContent::Snake, "a nested fork's write reached its parent");
+        expect(written.back() == written[0] || branch.getCellContent(lastX, lastY) == CellContent::Snake,
+               "a nested fork doesn't see its parent's writes");
+        branch.revert();
+        expect(branch.getCellContent(firstX, firstY) == CellContent::Snake && branch.getCopiedChunkCount() == 0,
+               "revert didn't bring the parent's view back");
+
+        rollout.revert();
+        bool backToGrid = true;
+        for (int cell : written) {
+            backToGrid &= rollout.getCellContent(cell % width, cell / width) == grid.getCellContent(cell % width, cell / width);
+        }
+        expect(backToGrid, "revert didn't bring the grid's view back");
+
+        std::cout << "  Snapshots: " << written.size() << " cells written through a fork, "
+                  << (passed ? "isolated from the grid and from each other" : "NOT isolated") << std::endl;
+        return passed;
+    }
+}
+
+// Counting replacement for the global operator new. It only adds an increment to the standard behavior,
+// so it is harmless outside the self test. The array and nothrow forms all end up here.
+void* operator new(std::size_t size) {
+    allocationCount++;
+    if (size == 0) {
+        size = 1;
+    }
+    while (true) {
+        void* memory = std::malloc(size);
+        if (memory != nullptr) {
+            return memory;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+bool runSelfTest() {
+    const int size = 256;
+    Grid grid(size, size, CellLayout::Bytes, 1);
+    Random random(7);
+    for (int i = 0; i < size * size / 5; ++i) {
+        int x = static_cast<int>(random.below(size));
+        int y = static_cast<int>(random.below(size));
+        if (grid.getCellContent(x, y) == CellContent::Empty) {
+            grid.setCellContent(x, y, CellContent::Obstacle);
+        }
+    }
+
+    // A few goals, each approached from several starts, so the incremental planners also reuse their trees
+    std::vector<Query> queries;
+    auto randomWalkableCell = [&](int& x, int& y) {
+        do {
+            x = static_cast<int>(random.below(size));
+            y = static_cast<int>(random.below(size));
+        } while (!grid.isWalkable(x, y));
+    };
+    for (int goal = 0; goal < 8; ++goal) {
+        Query query;
+        randomWalkableCell(query.goalX, query.goalY);
+        for (int start = 0; start < 4; ++start) {
+            randomWalkableCell(query.startX, query.startY);
+            query.editX = query.editY = -1;
+            const int offsets[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+            for (const auto& offset : offsets) {
+                int x = query.startX + offset[0];
+                int y = query.startY + offset[1];
+                if (x >= 0 && x < size && y >= 0 && y < size && grid.getCellContent(x, y) == CellContent::Empty &&
+                    (x != query.goalX || y != query.goalY)) {
+                    query.editX = x;
+                    query.editY = y;
+                    break;
+                }
+            }
+            queries.push_back(query);
+        }
+    }
+
+    std::vector<int> path;
+    IncrementalPlanner incrementalPlanner(grid);
+    HierarchicalPathfinder hierarchicalPathfinder(grid);
+    FlowField flowField(grid);
+    BitWavefront bitWavefront(grid);
+
+    std::cout << "Self test: heap allocations in steady-state path queries with a cell edited before each, " << size << "x" << size << " board" << std::endl;
+    bool passed = true;
+    passed &= checkAllocations(grid, "A*", queries, [&](const Query& q) {
+        return grid.findPath(q.startX, q.startY, q.goalX, q.goalY, path);
+    });
+    passed &= checkAllocations(grid, "Jump point", queries, [&](const Query& q) {
+        return grid.findPath(q.startX, q.startY, q.goalX, q.goalY, path, PathAlgorithm::JumpPoint);
+    });
+    passed &= checkAllocations(grid, "D* Lite", queries, [&](const Query& q) {
+        return incrementalPlanner.findPath(q.startX, q.startY, q.goalX, q.goalY, path);
+    });
+    passed &= checkAllocations(grid, "HPA*", queries, [&](const Query& q) {
+        return hierarchicalPathfinder.findPath(q.startX, q.startY, q.goalX, q.goalY, path);
+    });
+    passed &= checkAllocations(grid, "Flow field", queries, [&](const Query& q) {
+        int nextX, nextY;
+        flowField.setGoal(q.goalX, q.goalY);
+        return flowField.getNextStep(q.startX, q.startY, nextX, nextY);
+    });
+    passed &= checkAllocations(grid, "Bit wavefront", queries, [&](const Query& q) {
+        return bitWavefront.findPath(q.startX, q.startY, q.goalX, q.goalY, path);
+    });
+
+    passed &= checkSnapshots(grid, random);
+
+    std::cout << (passed ? "Self test passed" : "Self test FAILED") << std::endl;
+    return passed;
+}
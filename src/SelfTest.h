@@ -0,0 +1,10 @@
+#ifndef SELF_TEST_H
+#define SELF_TEST_H
+
+// Checks that steady-state path queries do no heap allocation. Every planner answers the same queries,
+// with a cell flipped before each, until warm; during the counted round operator new must not be called at all.
+// Then checks that GridSnapshot forks keep their writes to themselves.
+// Prints one line per check and returns true if they all passed.
+bool runSelfTest();
+
+#endif // SELF_TEST_H
@@ -1,114 +1,284 @@
 #include "Snake.h"
 #include "Grid.h"
+#include "IncrementalPlanner.h"
+#include "HierarchicalPathfinder.h"
+#include "FlowField.h"
+#include "BitWavefront.h"
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    void directionStep(Direction direction, int& dx, int& dy) {
+        dx = 0;
+        dy = 0;
+        switch (direction) {
+        case Direction::UP:    dy = -1; break;
+        case Direction::DOWN:  dy = 1; break;
+        case Direction::LEFT:  dx = -1; break;
+        case Direction::RIGHT: dx = 1; break;
+        }
+    }
+}
 
 Snake::Snake(Grid& InGrid, Position pos) : grid(InGrid) {
-	// Initialize the snake with a default position
-    body.push_back(pos); 
-    positionQueues.push_back(std::queue<Position>());
-    Position bodypart = pos;
-    bodypart.z -= 1;
-    body.push_back(bodypart);
-    positionQueues.push_back(std::queue<Position>());
+	// Initialize the snake with a default position, its second segment one cell behind the head
+    cellRefs.assign(grid.getWidth() * grid.getHeight(), 0);
+    placeBody((int)std::floor(pos.x + halfWidth()), (int)std::floor(pos.z + halfHeight()));
+}
 
+// The trail is seeded with the straight run from the tail to the head, as if the snake had just moved there.
+// The tail goes one cell above the head, or on the head itself when that cell is off the board or blocked.
+void Snake::placeBody(int x, int y) {
+    headX = x;
+    headY = y;
+    progress = 0;
+    int tailY = grid.isWalkable(headX, headY - 1) ? headY - 1 : headY;
+    length = 2;
+    trailCount = 0;
+    bodyStart = 0;
+    reserveTrail();
+    for (int i = 0; i <= segmentSpacing; ++i) {
+        // Update the grid with the initial snake position
+        int cell = (i < segmentSpacing ? tailY : headY) * grid.getWidth() + headX;
+        pushTrail(headX * segmentSpacing, tailY * segmentSpacing + i * (headY - tailY), cell);
+        occupy(cell);
+    }
 
-	// Update the grid with the initial snake position
-	grid.setCellContent(0, 0, CellContent::Snake);
+    tickTrailCount = trailCount;
+    tickBodyStart = bodyStart;
 
     currentDirection = Direction::DOWN; 
 }
 
-void Snake::move(Direction direction) {
-    currentDirection = direction;
-    Position Head = body.front();
-    switch (currentDirection) {
-    case Direction::UP:    Head.z -= 0.02f; break;
-    case Direction::DOWN:  Head.z += 0.02f; break;
-    case Direction::LEFT:  Head.x -= 0.02f; break;
-    case Direction::RIGHT: Head.x += 0.02f; break;
-    }
-    if (Head.x < -10.0f || Head.x > 10.0f || Head.z < -10.0f || Head.z > 10.0f)
-    {
-		std::cout << "Game Over" << std::endl;
-	}
-    else
-    {
-        body.front() = Head; // Directly update the head position
+void Snake::reset(int x, int y) {
+    if (!grid.isInside(x, y)) {
+        std::cerr << "Ignoring snake start off the board: " << x << ", " << y << std::endl;
+        return;
+    }
 
-        if (body.size() > 1 && positionQueues.size() > 1) {
-            positionQueues[1].push(Head); // Corrected to push the new head position
+    // With the board the same size, lift the old body; vacate leaves cells alone that a load already cleared
+    if (cellRefs.size() == static_cast<size_t>(grid.getWidth() * grid.getHeight())) {
+        for (size_t i = bodyStart; i < trailCount; ++i) {
+            vacate(trail[i & (trail.size() - 1)].cell);
         }
+    }
+    cellRefs.assign(grid.getWidth() * grid.getHeight(), 0);
+
+    // The planners were sized for the old board and may no longer be listening to this one
+    incrementalPlanner.reset();
+    hierarchicalPathfinder.reset();
+    flowField.reset();
+    bitWavefront.reset();
+
+    placeBody(x, y);
+    currentPath.clear();
+    pathCache.valid = false;
+    gameOver = false;
+}
 
-        for (size_t i = 1; i < body.size(); i++) {
-            if (!positionQueues[i].empty() && positionQueues[i].size() > 50) {
-                body[i] = positionQueues[i].front();
-                positionQueues[i].pop();
-                if (i + 1 < positionQueues.size()) { // Added check to prevent out-of-range access
-                    positionQueues[i + 1].push(body[i]);
-                }
-            }
+Snake::~Snake() = default;
+
+void Snake::setClusterSize(int size) {
+    if (size < 2) {
+        std::cerr << "Ignoring invalid cluster size: " << size << std::endl;
+        return;
+    }
+    if (size != clusterSize) {
+        clusterSize = size;
+        hierarchicalPathfinder.reset(); // Rebuilt with the new clusters the next time it is used
+        pathCache.valid = false;
+    }
+}
+
+Position Snake::getSegment(size_t index) const {
+    return segmentAt(trailCount, bodyStart, index);
+}
+
+Position Snake::getSegment(size_t index, float alpha) const {
+    // A tick moves the snake at most once, so the entry the tail just left is still in the ring
+    Position from = segmentAt(tickTrailCount, tickBodyStart, index);
+    Position to = getSegment(index);
+    return Position(from.x + (to.x - from.x) * alpha, from.z + (to.z - from.z) * alpha);
+}
+
+Position Snake::segmentAt(size_t count, size_t start, size_t index) const {
+    // Segments beyond the recorded history (just grown) wait on the tail until the trail reaches them
+    size_t back = std::min(index * segmentSpacing, count - 1 - start);
+    const TrailEntry& entry = trail[(count - 1 - back) & (trail.size() - 1)];
+
+    // The board is drawn centred on the origin, with each cube on its cell's centre
+    return Position(entry.x / (float)segmentSpacing - halfWidth() + 0.5f, entry.y / (float)segmentSpacing - halfHeight() + 0.5f);
+}
+
+void Snake::pushTrail(int x, int y, int cell) {
+    trail[trailCount & (trail.size() - 1)] = { x, y, cell };
+    trailCount++;
+}
+
+void Snake::reserveTrail() {
+    size_t needed = (length - 1) * segmentSpacing + 1;
+    if (trail.size() >= needed) {
+        return;
+    }
+    size_t size = 1;
+    while (size < needed) {
+        size *= 2;
+    }
+
+    // Entries keep their logical index, so re-file the ones under the body with the new mask
+    std::vector<TrailEntry> grown(size);
+    for (size_t i = bodyStart; i < trailCount; ++i) {
+        grown[i & (size - 1)] = trail[i & (trail.size() - 1)];
+    }
+    trail.swap(grown);
+}
+
+void Snake::occupy(int cell) {
+    if (cellRefs[cell]++ == 0) {
+        unsigned int before = grid.getVersion();
+        grid.setCellContent(cell % grid.getWidth(), cell / grid.getWidth(), CellContent::Snake);
+        ownWalkabilityChanges += grid.getVersion() - before;
+    }
+}
+
+void Snake::vacate(int cell) {
+    // Leave the cell alone if something else (an obstacle dropped on the body) has taken it over
+    if (--cellRefs[cell] == 0 && grid.getCellContent(cell % grid.getWidth(), cell / grid.getWidth()) == CellContent::Snake) {
+        unsigned int before = grid.getVersion();
+        grid.setCellContent(cell % grid.getWidth(), cell / grid.getWidth(), CellContent::Empty);
+        ownWalkabilityChanges += grid.getVersion() - before;
+    }
+}
+
+void Snake::move(Direction direction) {
+    int dx, dy;
+    if (progress == 0) {
+        // On a cell centre: the head may turn, but not off the board
+        directionStep(direction, dx, dy);
+        if (headX + dx < 0 || headX + dx >= grid.getWidth() || headY + dy < 0 || headY + dy >= grid.getHeight())
+        {
+            if (!quiet) std::cout << "Game Over" << std::endl;
+            return;
         }
-        updateGrid();
+        currentDirection = direction;
+    }
+    directionStep(currentDirection, dx, dy);
+
+    // Past the last step the head is on the next cell's centre, and counts as being in that cell
+    progress++;
+    if (progress == segmentSpacing) {
+        headX += dx;
+        headY += dy;
+        progress = 0;
     }
+    pushTrail(headX * segmentSpacing + dx * progress, headY * segmentSpacing + dy * progress, headY * grid.getWidth() + headX);
+    updateGrid(); // The rest of the body follows from the trail
 }
 
 void Snake::grow()
 {
-    std::cout << "Growing snake" << std::endl;
+    if (!quiet) std::cout << "Growing snake" << std::endl;
 
-    body.push_back(body.back());
-    positionQueues.push_back(std::queue<Position>());
+    length++;
+    reserveTrail();
 
     grid.placePill();
-    std::cout << "Pill placed" << std::endl;
+    if (!quiet) std::cout << "Pill placed" << std::endl;
 }
 
 void Snake::updateGrid() {
-    for (int i = 0; i < grid.getHeight(); i++) {
-        for (int j = 0; j < grid.getWidth(); j++) {
-            if (grid.getCellContent(j, i) == CellContent::Snake) {
-				grid.setCellContent(j, i, CellContent::Empty);
-			}
-		}
-	}
-
-    switch (currentDirection) {
-        case Direction::UP:    offSetCorrection.z = -0.02; break;
-        case Direction::DOWN:  offSetCorrection.z = -0.98; break;
-        case Direction::LEFT:  offSetCorrection.x = -0.02; break;
-        case Direction::RIGHT: offSetCorrection.x = -0.98; break;
-    }
-
-    if (grid.getCellContent(round(body.front().x + 10 + offSetCorrection.x), round(body.front().z + 10 + offSetCorrection.z)) == CellContent::Pill)
+    CellContent entered = grid.getCellContent(headX, headY);
+    if (entered == CellContent::Pill)
     {
         grow();
 	}
 
-    if (grid.getCellContent(round(body.front().x + 10 + offSetCorrection.x), round(body.front().z + 10 + offSetCorrection.z)) == CellContent::Obstacle)
+    if (entered == CellContent::Obstacle)
     {
-        std::cout << "Game Over" << std::endl;
+        if (!quiet) std::cout << "Game Over" << std::endl;
 	}
 
-    for (auto& segment : body) {
-		grid.setCellContent(round(segment.x + 10 + offSetCorrection.x), round(segment.z + 10 + offSetCorrection.z), CellContent::Snake);
-	}
+    // The head's cell joins the body and the trail the tail has moved off leaves it. Cells in between keep their count,
+    // so a move that stays within the same cells doesn't change the grid version.
+    occupy(headY * grid.getWidth() + headX);
 
-    
+    size_t reach = (length - 1) * segmentSpacing;
+    while (trailCount - bodyStart > reach + 1) {
+        vacate(trail[bodyStart & (trail.size() - 1)].cell);
+        bodyStart++;
+    }
 }
 
 void Snake::calculateAndFollowPath() {
+    tickTrailCount = trailCount;
+    tickBodyStart = bodyStart;
     if (gameOver) return;
-    Position pillPosition = grid.getPillPosition(); 
 
-    Grid::Node* startNode = grid.getNode(round(body.front().x + 10 + offSetCorrection.x), round(body.front().z + 10 + offSetCorrection.z)); // Convert Position to grid coordinates as needed
-    
-    Grid::Node* goalNode = grid.getNode(pillPosition.x, pillPosition.z);
+    // Between cell centres the head can only carry on, so there is nothing to plan
+    if (progress != 0) {
+        move(currentDirection);
+        return;
+    }
+    // Head for the closest pill when there are several on the board
+    int pillCell = grid.getNearestPill(headX, headY);
+    if (pillCell < 0) {
+        return; // No pill to go to
+    }
+    int goalX = pillCell % grid.getWidth();
+    int goalY = pillCell / grid.getWidth();
 
-    auto pathNodes = grid.findPath(*startNode, *goalNode);
-    currentPath.clear();
-    for (auto node : pathNodes) {
-        currentPath.push_back(Position(node->x, node->y)); // Convert grid coordinates back to Position
+    // Nothing that could block the route has happened since it was planned: keep following it
+    if (pathCache.valid && !currentPath.empty() && currentPath.front() == headY * grid.getWidth() + headX) {
+        currentPath.erase(currentPath.begin()); // Reached
+    }
+    if (pathCache.valid && (!currentPath.empty() || pathCache.noRoute) && pathCache.foreignChanges == foreignWalkabilityChanges() &&
+        pathCache.goalX == goalX && pathCache.goalY == goalY) {
+        followPath();
+        return;
+    }
+
+    switch (pathStrategy) {
+    case PathStrategy::AStar:     grid.findPath(headX, headY, goalX, goalY, currentPath); break;
+    case PathStrategy::JumpPoint: grid.findPath(headX, headY, goalX, goalY, currentPath, PathAlgorithm::JumpPoint); break;
+    case PathStrategy::Incremental:
+        if (!incrementalPlanner) {
+            incrementalPlanner.reset(new IncrementalPlanner(grid));
+        }
+        incrementalPlanner->findPath(headX, headY, goalX, goalY, currentPath);
+        break;
+    case PathStrategy::Hierarchical:
+        if (!hierarchicalPathfinder) {
+            hierarchicalPathfinder.reset(new HierarchicalPathfinder(grid, clusterSize));
+        }
+        // Only the leg up to the next entrance: the rest of the route is refined as the head gets there
+        hierarchicalPathfinder->findNextLeg(headX, headY, goalX, goalY, currentPath);
+        break;
+    case PathStrategy::FlowField:
+        if (!flowField) {
+            flowField.reset(new FlowField(grid));
+        }
+        flowField->setGoal(goalX, goalY);
+
+        // Only the next cell is needed: the field already knows the way from every other one
+        currentPath.clear();
+        int nextX, nextY;
+        if (flowField->getNextStep(headX, headY, nextX, nextY)) {
+            currentPath.push_back(nextY * grid.getWidth() + nextX);
+        }
+        break;
+    case PathStrategy::Wavefront:
+        if (!bitWavefront) {
+            bitWavefront.reset(new BitWavefront(grid));
+        }
+        bitWavefront->findPath(headX, headY, goalX, goalY, currentPath);
+        break;
     }
+    pathCache.valid = true;
+    pathCache.foreignChanges = foreignWalkabilityChanges();
+    pathCache.goalX = goalX;
+    pathCache.noRoute = currentPath.empty();
+    pathCache.goalY = goalY;
 
     followPath();
 }
@@ -121,17 +291,17 @@ void Snake::GameOver()
 
 void Snake::followPath() {
     if (!currentPath.empty()) {
-        Position nextStep = currentPath.front();
-        currentPath.pop_front();
+        // Cells the head has reached are dropped from the front, so the first one is always next to the head
+        int nextStep = currentPath.front();
 
         // Determine direction based on the next step
-        Position directionVector = Position((nextStep.x - round(body.front().x + 10 + offSetCorrection.x)),(nextStep.z - round(body.front().z + 10 + offSetCorrection.z)));
-        
+        int dx = nextStep % grid.getWidth() - headX;
+        int dy = nextStep / grid.getWidth() - headY;
 
-        if (directionVector.x > 0) currentDirection = Direction::RIGHT;
-        else if (directionVector.x < 0) currentDirection = Direction::LEFT;
-        else if (directionVector.z > 0) currentDirection = Direction::DOWN;
-        else if (directionVector.z < 0) currentDirection = Direction::UP;
+        if (dx > 0) currentDirection = Direction::RIGHT;
+        else if (dx < 0) currentDirection = Direction::LEFT;
+        else if (dy > 0) currentDirection = Direction::DOWN;
+        else if (dy < 0) currentDirection = Direction::UP;
 
 
         // Move the snake in the determined direction
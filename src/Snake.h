@@ -1,39 +1,105 @@
 #pragma once
 #include <vector>
 #include "glm.hpp"
-#include <queue>
-#include <list>
+#include <memory>
+#include "Position.h"
+#include "Grid.h"
 
 enum class Direction { UP, DOWN, LEFT, RIGHT };
 
-class Grid;
-
-struct Position {
-    Position(float x, float z) : x(x), z(z) {}
-    Position() : x(0), z(0) {}
-    float x, z;
-    float y = 0.5; // Default y position for the snake
-    glm::vec3 toVec3() { return glm::vec3(x, y, z); }
+// How the snake plans its route to the pill
+enum class PathStrategy {
+    AStar,       // Grid::findPath from scratch on every call
+    JumpPoint,   // Grid::findPath with Jump Point Search
+    Incremental, // D* Lite tree kept alive between calls and repaired after edits
+    Hierarchical, // HPA* over clusters of the board, for very large grids
+    FlowField,    // Step down a distance field built from the pill, no per-move search
+    Wavefront     // Bit-parallel BFS (BitWavefront), exact shortest paths on big open boards
 };
 
+class IncrementalPlanner;
+class HierarchicalPathfinder;
+class FlowField;
+class BitWavefront;
+
 class Snake {
 public:
     Snake(Grid& InGrid, Position pos);
+    ~Snake();
     void move(Direction direction);
     void grow();
     void updateGrid();
     void calculateAndFollowPath();
-    std::vector<Position>& getBody() { return body; }
+    size_t getLength() const { return length; } // Segments, head included
+    int getHeadX() const { return headX; } // Cell the head is in (the one it is leaving, until it reaches the next centre)
+    int getHeadY() const { return headY; }
+    Position getSegment(size_t index) const; // World position for drawing; 0 is the head
+    Position getSegment(size_t index, float alpha) const; // Blended from before the last tick (0) to now (1), for rendering
+    const std::vector<int>& getPath() const { return currentPath; } // Cells of the route being followed, drawn as the path overlay
     void GameOver();
+    void setPathStrategy(PathStrategy strategy) { pathStrategy = strategy; pathCache.valid = false; }
+    void setQuiet(bool quiet) { this->quiet = quiet; } // No console messages (growth, game over), e.g. for headless runs
+    void setClusterSize(int size); // Cluster side for the Hierarchical strategy, at least 2; larger suits bigger boards
+    // Start over as a new two-segment snake with its head on cell (x, y), for instance at a level's start after it
+    // was loaded. The old body is taken off the grid where it still stands; the grid may have been resized since.
+    void reset(int x, int y);
 
 private:
     Grid& grid;
-    std::vector<Position> body;
-    std::vector<std::queue<Position>> positionQueues;
-    std::list<Position> currentPath; // Stores the current path to the pill
+    bool quiet = false;
+
+    // The simulation is all integers: the head's cell, plus how many of the segmentSpacing steps towards the
+    // next cell it has taken. It only turns on a cell centre (progress 0). World positions are for drawing only.
+    static const int segmentSpacing = 50; // Moves per cell, at 0.02 units per move
+    int headX = 0, headY = 0;
+    int progress = 0;
+
+    // Every head position so far, newest last, in a ring buffer. Segment i is where the head was
+    // i * segmentSpacing moves ago, so a move writes only the new head whatever the length.
+    struct TrailEntry {
+        int x, y; // In steps (segmentSpacing per cell) from the centre of cell (0, 0)
+        int cell; // Grid cell the entry was counted on (y * width + x)
+    };
+    std::vector<TrailEntry> trail; // Power-of-two size, always longer than the body's reach
+    size_t trailCount = 0; // Head positions recorded so far; the newest is at (trailCount - 1)
+    size_t bodyStart = 0; // Oldest entry still under the body: the tail. Older ones may be overwritten.
+    size_t length = 0;
+    size_t tickTrailCount = 0, tickBodyStart = 0; // Trail as it stood when the last tick began
+    Position segmentAt(size_t count, size_t start, size_t index) const; // Segment of the trail ending at count, tail at start
+    void pushTrail(int x, int y, int cell);
+    void placeBody(int x, int y); // Lay a new two-segment body down with its head on cell (x, y)
+    void reserveTrail(); // Grow the ring when the body gets longer than it reaches
+
+    // How many trail entries under the body lie on each cell. A move adds the head's entry and drops
+    // the one the tail has left, and only a count reaching or leaving zero changes the grid.
+    std::vector<int> cellRefs;
+    void occupy(int cell);
+    void vacate(int cell);
+    unsigned int ownWalkabilityChanges = 0; // Grid version bumps caused by occupy and vacate
+    unsigned int foreignWalkabilityChanges() const { return grid.getVersion() - ownWalkabilityChanges; }
+    std::vector<int> currentPath; // Stores the current path to the pill; the planners write straight into it
+
+    // What currentPath was planned against. Its front is the next cell for the head; cells are dropped from the
+    // front as the head reaches them. The snake's own moves can't block the cells ahead (its body only grows
+    // onto cells already taken), so the route is kept until the goal moves or something else changes walkability.
+    struct PathCache {
+        bool valid = false;
+        unsigned int foreignChanges = 0; // foreignWalkabilityChanges() when the route was planned
+        int goalX = 0, goalY = 0;
+        bool noRoute = false; // The planner found nothing: the snake waits, and so does the next search
+    };
+    PathCache pathCache;
+    // The board is centred on the world origin, so world coordinates run from -half to +half on each axis
+    float halfWidth() const { return grid.getWidth() / 2.0f; }
+    float halfHeight() const { return grid.getHeight() / 2.0f; }
     void followPath(); // Follows the calculated path
+    PathStrategy pathStrategy = PathStrategy::AStar;
+    std::unique_ptr<IncrementalPlanner> incrementalPlanner; // Created the first time the Incremental strategy is used
+    std::unique_ptr<HierarchicalPathfinder> hierarchicalPathfinder; // Likewise for Hierarchical
+    int clusterSize = 16; // Passed to hierarchicalPathfinder when it is created
+    std::unique_ptr<FlowField> flowField; // Likewise for FlowField
+    std::unique_ptr<BitWavefront> bitWavefront; // Likewise for Wavefront
     
     bool gameOver = false;
     Direction currentDirection;
-    Position offSetCorrection;
 };
\ No newline at end of file
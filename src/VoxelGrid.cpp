@@ -0,0 +1,181 @@
+#include "VoxelGrid.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+
+namespace {
+    const int directions[6][3] = { { -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 } };
+
+    // The three bits of a coordinate inside its brick, spread three apart: bit i moves to bit 3i
+    const uint32_t brickSpread[8] = { 0, 1, 8, 9, 64, 65, 72, 73 };
+
+    int clampSide(int side) {
+        return side < 1 ? 1 : (side > VoxelGrid::maxSize ? VoxelGrid::maxSize : side);
+    }
+
+    uint32_t hashCell(uint32_t cell) {
+        return cell * 2654435761u;
+    }
+}
+
+VoxelGrid::VoxelGrid(int sizeX, int sizeY, int sizeZ) : sizeX(clampSide(sizeX)), sizeY(clampSide(sizeY)), sizeZ(clampSide(sizeZ)) {
+    if (this->sizeX != sizeX || this->sizeY != sizeY || this->sizeZ != sizeZ) {
+        std::cerr << "Voxel arena " << sizeX << "x" << sizeY << "x" << sizeZ << " is out of range, using "
+                  << this->sizeX << "x" << this->sizeY << "x" << this->sizeZ << std::endl;
+    }
+    bricksX = (this->sizeX + 7) / 8;
+    bricksY = (this->sizeY + 7) / 8;
+    int bricksZ = (this->sizeZ + 7) / 8;
+    cells.assign(static_cast<size_t>(bricksX) * bricksY * bricksZ * 512, CellContent::Empty);
+}
+
+uint32_t VoxelGrid::cellIndex(int x, int y, int z) const {
+    uint32_t brick = static_cast<uint32_t>(((z >> 3) * bricksY + (y >> 3)) * bricksX + (x >> 3));
+    return (brick << 9) | brickSpread[x & 7] | (brickSpread[y & 7] << 1) | (brickSpread[z & 7] << 2);
+}
+
+CellContent VoxelGrid::getCellContent(int x, int y, int z) const {
+    return inside(x, y, z) ? cells[cellIndex(x, y, z)] : CellContent::Obstacle;
+}
+
+void VoxelGrid::setCellContent(int x, int y, int z, CellContent content) {
+    if (inside(x, y, z)) {
+        cells[cellIndex(x, y, z)] = content;
+    }
+}
+
+bool VoxelGrid::isWalkable(int x, int y, int z) const {
+    CellContent content = getCellContent(x, y, z);
+    return content != CellContent::Obstacle && content != CellContent::Snake;
+}
+
+void VoxelGrid::pushOpen(const OpenEntry& entry) {
+    openList.push_back(entry);
+    std::push_heap(openList.begin(), openList.end(), std::greater<OpenEntry>());
+}
+
+void VoxelGrid::beginSearch() {
+    if (searchTable.empty()) {
+        searchTable.resize(1024);
+        slotStamps.resize(1024);
+    }
+    searchCount = 0;
+    slotStamps.advance();
+}
+
+VoxelGrid::SearchEntry* VoxelGrid::findEntry(uint32_t cell) {
+    size_t mask = searchTable.size() - 1;
+    for (size_t slot = hashCell(cell) & mask; ; slot = (slot + 1) & mask) {
+        if (!slotStamps.isCurrent(slot)) return nullptr;
+        if (searchTable[slot].cell == cell) return &searchTable[slot];
+    }
+}
+
+VoxelGrid::SearchEntry* VoxelGrid::addEntry(uint32_t cell, int x, int y, int z) {
+    if ((searchCount + 1) * 2 > static_cast<int>(searchTable.size())) {
+        growSearchTable();
+    }
+    size_t mask = searchTable.size() - 1;
+    size_t slot = hashCell(cell) & mask;
+    while (!slotStamps.touch(slot)) {
+        slot = (slot + 1) & mask;
+    }
+
+    SearchEntry& entry = searchTable[slot];
+    entry.cell = cell;
+    entry.cost = 0;
+    entry.x = static_cast<uint16_t>(x);
+    entry.y = static_cast<uint16_t>(y);
+    entry.z = static_cast<uint16_t>(z);
+    entry.parentDirection = 6;
+    entry.closed = false;
+    searchCount++;
+    return &entry;
+}
+
+void VoxelGrid::growSearchTable() {
+    std::vector<SearchEntry> old;
+    old.swap(searchTable);
+    EpochStamps oldStamps = slotStamps;
+    searchTable.resize(old.size() * 2);
+    slotStamps.resize(searchTable.size());
+    size_t mask = searchTable.size() - 1;
+    for (size_t i = 0; i < old.size(); ++i) {
+        if (!oldStamps.isCurrent(i)) continue;
+        size_t slot = hashCell(old[i].cell) & mask;
+        while (!slotStamps.touch(slot)) {
+            slot = (slot + 1) & mask;
+        }
+        searchTable[slot] = old[i];
+    }
+}
+
+bool VoxelGrid::findPath(const Voxel& start, const Voxel& goal, std::vector<Voxel>& path) {
+    path.clear();
+    lastExpandedNodes = 0;
+    if (!inside(start.x, start.y, start.z) || !isWalkable(goal.x, goal.y, goal.z)) {
+        return false;
+    }
+
+    auto heuristic = [&](int x, int y, int z) {
+        return std::abs(x - goal.x) + std::abs(y - goal.y) + std::abs(z - goal.z);
+    };
+
+    beginSearch();
+    uint32_t goalCell = cellIndex(goal.x, goal.y, goal.z);
+    uint32_t startCell = cellIndex(start.x, start.y, start.z);
+    addEntry(startCell, start.x, start.y, start.z);
+    int startH = heuristic(start.x, start.y, start.z);
+    openList.clear();
+    pushOpen(OpenEntry(startH, startH, startCell));
+
+    while (!openList.empty()) {
+        std::pop_heap(openList.begin(), openList.end(), std::greater<OpenEntry>());
+        OpenEntry top = openList.back();
+        openList.pop_back();
+        uint32_t cell = std::get<2>(top);
+        SearchEntry* current = findEntry(cell);
+        if (current->closed || std::get<0>(top) - std::get<1>(top) != current->cost) continue; // Stale copy
+        current->closed = true;
+        lastExpandedNodes++;
+
+        if (cell == goalCell) {
+            // Walk back along the recorded directions
+            int x = goal.x, y = goal.y, z = goal.z;
+            for (SearchEntry* entry = current; entry->parentDirection != 6; ) {
+                path.push_back({ x, y, z });
+                const int* step = directions[entry->parentDirection];
+                x -= step[0];
+                y -= step[1];
+                z -= step[2];
+                entry = findEntry(cellIndex(x, y, z));
+            }
+            std::reverse(path.begin(), path.end());
+            return true;
+        }
+
+        int x = current->x, y = current->y, z = current->z;
+        int cost = current->cost + 1;
+        for (int direction = 0; direction < 6; ++direction) {
+            int nextX = x + directions[direction][0];
+            int nextY = y + directions[direction][1];
+            int nextZ = z + directions[direction][2];
+            if (!isWalkable(nextX, nextY, nextZ)) continue;
+
+            uint32_t next = cellIndex(nextX, nextY, nextZ);
+            SearchEntry* entry = findEntry(next);
+            if (entry == nullptr) {
+                entry = addEntry(next, nextX, nextY, nextZ); // May move the table; current isn't used after this
+            }
+            else if (entry->closed || entry->cost <= cost) {
+                continue;
+            }
+            entry->cost = cost;
+            entry->parentDirection = static_cast<uint8_t>(direction);
+            int h = heuristic(nextX, nextY, nextZ);
+            pushOpen(OpenEntry(cost + h, h, next));
+        }
+    }
+    return false;
+}
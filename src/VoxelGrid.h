@@ -0,0 +1,72 @@
+#ifndef VOXEL_GRID_H
+#define VOXEL_GRID_H
+
+#include <vector>
+#include <cstdint>
+#include <tuple>
+#include "CellContent.h"
+#include "EpochStamps.h"
+
+struct Voxel {
+    int x, y, z;
+};
+
+// Fully 3D arena: x, y, z cells, 6-connected, at most maxSize along each axis. Cells are stored in 8x8x8
+// bricks, Morton (Z-order) inside each brick, so the six neighbors of a cell sit close together in memory
+// along every axis, not just along x. Bricks are laid out row by row, so the storage is each side rounded
+// up to a multiple of 8, not a cube of the largest side.
+//
+// findPath is A* tuned for big volumes: its bookkeeping lives in a hash table sized by the cells a search
+// actually reaches, so a query over a 256^3 arena costs what it explores, not a per-voxel array pass.
+class VoxelGrid {
+public:
+    static const int maxSize = 1024; // Per axis; keeps every cell index within 32 bits
+
+    VoxelGrid(int sizeX, int sizeY, int sizeZ); // Sides outside 1..maxSize are clamped, with a message
+
+    int getSizeX() const { return sizeX; }
+    int getSizeY() const { return sizeY; }
+    int getSizeZ() const { return sizeZ; }
+
+    CellContent getCellContent(int x, int y, int z) const; // Obstacle outside the arena
+    void setCellContent(int x, int y, int z, CellContent content);
+    bool isWalkable(int x, int y, int z) const;
+
+    // Shortest 6-connected path, start excluded and goal included, written into a reused vector
+    bool findPath(const Voxel& start, const Voxel& goal, std::vector<Voxel>& path);
+    int getLastExpandedNodes() const { return lastExpandedNodes; }
+
+private:
+    // Search bookkeeping for one reached cell
+    struct SearchEntry {
+        uint32_t cell; // Index into cells
+        int cost;
+        uint16_t x, y, z;
+        uint8_t parentDirection; // Direction taken to get here, 6 for the start
+        bool closed;
+    };
+
+    int sizeX, sizeY, sizeZ;
+    int bricksX, bricksY; // Bricks along x and y; z needs no stride
+    std::vector<CellContent> cells; // Brick after brick, 512 cells each in Morton order
+
+    // Open list without decrease-key: a cell is pushed again when its cost drops, stale copies are skipped.
+    // Ordered by f, then h, so the search runs straight at the goal when nothing is in the way.
+    typedef std::tuple<int, int, uint32_t> OpenEntry; // (f, h, cell)
+    std::vector<OpenEntry> openList; // Binary heap, kept to reuse its storage
+
+    std::vector<SearchEntry> searchTable; // Open addressing, power-of-two capacity, at most half full
+    EpochStamps slotStamps; // Slots written by the current search; every other slot is free
+    int searchCount = 0;
+    int lastExpandedNodes = 0;
+
+    uint32_t cellIndex(int x, int y, int z) const;
+    bool inside(int x, int y, int z) const { return x >= 0 && x < sizeX && y >= 0 && y < sizeY && z >= 0 && z < sizeZ; }
+    void beginSearch();
+    void pushOpen(const OpenEntry& entry);
+    SearchEntry* findEntry(uint32_t cell); // nullptr if the cell wasn't reached by this search
+    SearchEntry* addEntry(uint32_t cell, int x, int y, int z);
+    void growSearchTable();
+};
+
+#endif // VOXEL_GRID_H
@@ -0,0 +1,60 @@
+#include "VoxelSnake.h"
+#include <iostream>
+
+namespace {
+    const int maxPillDraws = 4096; // A free voxel is almost always found in a few draws
+}
+
+VoxelSnake::VoxelSnake(VoxelGrid& grid, const Voxel& start, uint64_t seed) : grid(grid), random(seed, RandomStream::VoxelPills) {
+    body.push_back(start);
+    grid.setCellContent(start.x, start.y, start.z, CellContent::Snake);
+    placePill();
+}
+
+// Random draws until one lands on a free voxel
+bool VoxelSnake::placePill() {
+    for (int draw = 0; draw < maxPillDraws; ++draw) {
+        int x = static_cast<int>(random.below(grid.getSizeX()));
+        int y = static_cast<int>(random.below(grid.getSizeY()));
+        int z = static_cast<int>(random.below(grid.getSizeZ()));
+        if (grid.getCellContent(x, y, z) == CellContent::Empty) {
+            grid.setCellContent(x, y, z, CellContent::Pill);
+            pill = { x, y, z };
+            pillPlaced = true;
+            return true;
+        }
+    }
+    if (!quiet) std::cout << "No free voxel for a pill" << std::endl;
+    pillPlaced = false;
+    return false;
+}
+
+void VoxelSnake::step() {
+    if (!pillPlaced && !placePill()) {
+        return;
+    }
+
+    // Keep following the route while its next cell is free; plan again once it runs out or is blocked
+    if (pathStep >= path.size() || !grid.isWalkable(path[pathStep].x, path[pathStep].y, path[pathStep].z)) {
+        pathStep = 0;
+        if (!grid.findPath(body.front(), pill, path)) {
+            return;
+        }
+    }
+
+    Voxel next = path[pathStep++];
+    bool eating = grid.getCellContent(next.x, next.y, next.z) == CellContent::Pill;
+    grid.setCellContent(next.x, next.y, next.z, CellContent::Snake);
+    body.push_front(next);
+    if (eating) {
+        if (!quiet) std::cout << "Growing snake" << std::endl;
+        placePill();
+        path.clear(); // The route led to the pill just eaten
+        pathStep = 0;
+    }
+    else {
+        const Voxel& tail = body.back();
+        grid.setCellContent(tail.x, tail.y, tail.z, CellContent::Empty);
+        body.pop_back();
+    }
+}
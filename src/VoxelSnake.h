@@ -0,0 +1,38 @@
+#ifndef VOXEL_SNAKE_H
+#define VOXEL_SNAKE_H
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include "VoxelGrid.h"
+#include "Random.h"
+
+// Snake for the 3D voxel arena: one cell per step in any of the six directions, along the route
+// VoxelGrid::findPath plans to the pill. Its body is marked Snake in the arena, so routes go around it.
+// It keeps the pill too: eating it grows the body and drops the next one on a random free voxel.
+class VoxelSnake {
+public:
+    VoxelSnake(VoxelGrid& grid, const Voxel& start, uint64_t seed);
+
+    void step(); // Move one cell towards the pill; stays put while the pill can't be reached
+    size_t getLength() const { return body.size(); }
+    const std::deque<Voxel>& getBody() const { return body; } // Head first
+    bool hasPill() const { return pillPlaced; }
+    const Voxel& getPill() const { return pill; }
+    const std::vector<Voxel>& getPath() const { return path; } // Route being followed, including cells already taken
+    void setQuiet(bool quiet) { this->quiet = quiet; } // No console messages, e.g. for headless runs
+
+private:
+    VoxelGrid& grid;
+    Random random;
+    bool quiet = false;
+    std::deque<Voxel> body;
+    Voxel pill;
+    bool pillPlaced = false;
+    std::vector<Voxel> path;
+    size_t pathStep = 0; // Next cell of path to move into
+
+    bool placePill();
+};
+
+#endif // VOXEL_SNAKE_H
@@ -0,0 +1,138 @@
+#include "WorldSnake.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+    const int windowSide = 2 * (WorldSnake::maxRoom + 1) + 1; // A fill of maxRoom cells from a neighbor of the head stays inside
+}
+
+WorldSnake::WorldSnake(ChunkedGrid& world, const WorldCell& start, uint64_t seed)
+    : world(world), random(seed, RandomStream::WorldPills), seen(windowSide * windowSide, 0) {
+    body.push_back(start);
+    previous = start;
+    world.setCellContent(start.x, start.y, CellContent::Snake);
+    placePill();
+}
+
+WorldCell WorldSnake::randomCellNear(const WorldCell& center, int range) {
+    int x = center.x + static_cast<int>(random.below(2 * range + 1)) - range;
+    int y = center.y + static_cast<int>(random.below(2 * range + 1)) - range;
+    return WorldCell{ x, y };
+}
+
+bool WorldSnake::isFree(int x, int y) const {
+    CellContent content = world.getCellContent(x, y);
+    return content == CellContent::Empty || content == CellContent::Pill;
+}
+
+// The world is mostly empty, so a few draws always find a free cell. Obstacles never touch the pill,
+// which keeps it reachable by a greedy walker in all but unlucky layouts.
+void WorldSnake::placePill(bool withObstacles) {
+    WorldCell head = body.front();
+    do {
+        pill = randomCellNear(head, pillRange);
+    } while (world.getCellContent(pill.x, pill.y) != CellContent::Empty);
+    world.setCellContent(pill.x, pill.y, CellContent::Pill);
+    if (!withObstacles) {
+        return;
+    }
+
+    for (int i = 0; i < obstaclesPerPill; ++i) {
+        WorldCell cell = randomCellNear(pill, pillRange / 2);
+        bool besidePill = std::abs(cell.x - pill.x) <= 1 && std::abs(cell.y - pill.y) <= 1;
+        bool besideHead = std::abs(cell.x - head.x) <= 1 && std::abs(cell.y - head.y) <= 1;
+        if (!besidePill && !besideHead && world.getCellContent(cell.x, cell.y) == CellContent::Empty) {
+            world.setCellContent(cell.x, cell.y, CellContent::Obstacle);
+        }
+    }
+}
+
+int WorldSnake::roomAt(const WorldCell& cell, int limit) {
+    const WorldCell& head = body.front();
+    if (++seenEpoch == 0) {
+        std::fill(seen.begin(), seen.end(), 0);
+        seenEpoch = 1;
+    }
+    auto mark = [&](int x, int y) {
+        int wx = x - head.x + windowSide / 2;
+        int wy = y - head.y + windowSide / 2;
+        if (wx < 0 || wx >= windowSide || wy < 0 || wy >= windowSide || seen[wy * windowSide + wx] == seenEpoch) {
+            return false;
+        }
+        seen[wy * windowSide + wx] = seenEpoch;
+        return true;
+    };
+
+    const int offsets[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+    fill.clear();
+    fill.push_back(cell);
+    mark(cell.x, cell.y);
+    for (size_t head = 0; head < fill.size() && static_cast<int>(fill.size()) < limit; ++head) {
+        for (const auto& offset : offsets) {
+            int x = fill[head].x + offset[0];
+            int y = fill[head].y + offset[1];
+            if (isFree(x, y) && mark(x, y)) {
+                fill.push_back(WorldCell{ x, y });
+            }
+        }
+    }
+    return static_cast<int>(fill.size());
+}
+
+void WorldSnake::step() {
+    if (gameOver) {
+        return;
+    }
+    if (++stepsSincePill > stepsPerPill) {
+        world.setCellContent(pill.x, pill.y, CellContent::Empty);
+        placePill(false);
+        stepsSincePill = 0;
+    }
+
+    const WorldCell head = body.front();
+    const int offsets[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+    // Closest free neighbor to the pill; when none gets closer, the least bad one lets the snake slide past.
+    // A step into a pocket smaller than the body only wins when every other step does too.
+    int needed = static_cast<int>(body.size()) < maxRoom ? static_cast<int>(body.size()) : maxRoom;
+    long long bestScore = -1;
+    WorldCell next = head;
+    for (const auto& offset : offsets) {
+        int x = head.x + offset[0];
+        int y = head.y + offset[1];
+        if (!isFree(x, y)) continue;
+        long long score = std::abs(pill.x - x) + std::abs(pill.y - y);
+        if (x == previous.x && y == previous.y) {
+            score += 2 * pillRange; // Last resort, or the snake would rock between two cells
+        }
+        int room = roomAt(WorldCell{ x, y }, needed);
+        if (room < needed) {
+            score += static_cast<long long>(needed - room) << 32;
+        }
+        if (bestScore < 0 || score < bestScore) {
+            bestScore = score;
+            next = WorldCell{ x, y };
+        }
+    }
+    if (bestScore < 0) {
+        gameOver = true;
+        if (!quiet) std::cout << "Game over: the snake is boxed in" << std::endl;
+        return;
+    }
+
+    bool eating = world.getCellContent(next.x, next.y) == CellContent::Pill;
+    world.setCellContent(next.x, next.y, CellContent::Snake);
+    body.push_front(next);
+    previous = head;
+    if (eating) {
+        if (!quiet) std::cout << "Growing snake" << std::endl;
+        placePill();
+        stepsSincePill = 0;
+    }
+    else {
+        const WorldCell& tail = body.back();
+        world.setCellContent(tail.x, tail.y, CellContent::Empty);
+        body.pop_back();
+    }
+}
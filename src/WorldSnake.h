@@ -0,0 +1,57 @@
+#ifndef WORLD_SNAKE_H
+#define WORLD_SNAKE_H
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include "ChunkedGrid.h"
+#include "Random.h"
+
+struct WorldCell {
+    int x, y;
+};
+
+// Snake for the unbounded world: a ChunkedGrid with no edges, where only the chunks holding the snake,
+// the pill and the obstacles dropped around pills take memory. Each pill lands within pillRange cells
+// of the head, with a few obstacles scattered near it, so the world fills in along the snake's trail.
+// There is no board to plan over: the snake steps to the free neighbor closest to the pill, and
+// sidesteps when every step closer is blocked. Steps into a pocket too small for the body are avoided
+// while there is another way. A pill it keeps circling without reaching is moved.
+class WorldSnake {
+public:
+    static const int pillRange = 48;
+    static const int obstaclesPerPill = 6;
+    static const int maxRoom = 64; // Free cells a step must lead to, at most, to count as safe
+    static const int stepsPerPill = 16 * pillRange; // Past this many steps the pill counts as out of reach
+
+    WorldSnake(ChunkedGrid& world, const WorldCell& start, uint64_t seed);
+
+    void step(); // Move one cell; the game is over once the head is boxed in
+    bool isGameOver() const { return gameOver; }
+    size_t getLength() const { return body.size(); }
+    const std::deque<WorldCell>& getBody() const { return body; } // Head first
+    const WorldCell& getPill() const { return pill; }
+    void setQuiet(bool quiet) { this->quiet = quiet; } // No console messages, e.g. for headless runs
+
+private:
+    ChunkedGrid& world;
+    Random random;
+    bool quiet = false;
+    std::deque<WorldCell> body;
+    WorldCell pill;
+    WorldCell previous; // Cell the head just left; only stepped back into when nothing else is free
+    int stepsSincePill = 0;
+    bool gameOver = false;
+
+    // Scratch for roomAt: a window around the head wide enough for any fill it does
+    std::vector<uint32_t> seen;
+    uint32_t seenEpoch = 0;
+    std::vector<WorldCell> fill;
+
+    void placePill(bool withObstacles = true);
+    WorldCell randomCellNear(const WorldCell& center, int range);
+    bool isFree(int x, int y) const;
+    int roomAt(const WorldCell& cell, int limit); // Free cells reachable from cell, counting up to limit
+};
+
+#endif // WORLD_SNAKE_H